@@ -0,0 +1,105 @@
+// Benchmark de la tabla de trabajos: memoria y rendimiento al cargar N
+// trabajos (por defecto 1M) y hacerlos circular por la cola.
+//
+// ./bench_jobs [N] [vueltas]
+//
+// Se compila junto con scheduler.c (sin su main) para medir exactamente las
+// mismas estructuras que usa el planificador. Los resultados van a stderr;
+// stdout se descarta porque la carga imprime una línea por trabajo.
+#define SCHEDULER_NO_MAIN
+#include "scheduler.c"
+
+#include <malloc.h>
+
+double secondsSince(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    long n = (argc > 1) ? atol(argv[1]) : 1000000;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 10;
+    if (n <= 0 || rounds <= 0) {
+        fprintf(stderr, "Usage: %s [jobs] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    // Fichero de trabajos con las siete rutas de work/ repetidas
+    char path[] = "/tmp/bench_jobsXXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp failed");
+        return 1;
+    }
+    FILE *f = fdopen(fd, "w");
+    for (long i = 0; i < n; i++) {
+        fprintf(f, "../work/work%ld\n", i % 7 + 1);
+    }
+    fclose(f);
+
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("freopen failed");
+        return 1;
+    }
+    launchBackend = LAUNCH_FORK; // No hace falta abrir los ejecutables
+
+    struct timespec start;
+    Queue *q = createQueue();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    loadProcessesFromFile(path, q);
+    double loadSec = secondsSince(&start);
+    unlink(path);
+
+    struct mallinfo2 mi = mallinfo2();
+
+    // Rotación pura: sacar y volver a encolar (lo que hace RR)
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < rounds; r++) {
+        for (long i = 0; i < n; i++) {
+            enqueue(q, dequeue(q));
+        }
+    }
+    double rotateSec = secondsSince(&start);
+
+    // Reciclado: cada trabajo termina y llega uno nuevo con la misma ruta
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < rounds; r++) {
+        for (long i = 0; i < n; i++) {
+            Process *old = dequeue(q);
+            const char *route = old->route;
+            const char *name = old->executableName;
+            freeProcess(old);
+            Process *p = allocProcess();
+            p->route = route;
+            p->executableName = name;
+            enqueue(q, p);
+        }
+    }
+    double recycleSec = secondsSince(&start);
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    double ops = (double)n * rounds;
+    fprintf(stderr, "jobs:            %ld\n", n);
+    fprintf(stderr, "distinct routes: %d\n", routeCache.count);
+    fprintf(stderr, "sizeof(Process): %zu bytes\n", sizeof(Process));
+    // Los bloques del pool son grandes y malloc los sirve con mmap (hblkhd)
+    double heap = (double)mi.uordblks + mi.hblkhd;
+    fprintf(stderr, "heap in use:     %.1f MB (%.1f bytes/job)\n",
+            heap / 1048576.0, heap / n);
+    fprintf(stderr, "peak RSS:        %.1f MB\n", ru.ru_maxrss / 1024.0);
+    fprintf(stderr, "load:            %.3f s (%.0f ns/job)\n", loadSec, loadSec * 1e9 / n);
+    fprintf(stderr, "rotate:          %.3f s (%.1f ns/op)\n", rotateSec, rotateSec * 1e9 / ops);
+    fprintf(stderr, "recycle:         %.3f s (%.1f ns/op)\n", recycleSec, recycleSec * 1e9 / ops);
+
+    while (!isQueueEmpty(q)) {
+        freeProcess(dequeue(q));
+    }
+    destroyQueue(q);
+    routeCacheFree();
+    destroyPool();
+    return 0;
+}
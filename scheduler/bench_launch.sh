@@ -0,0 +1,25 @@
+#!/bin/sh
+# Compara los backends de lanzamiento (fork+execlp frente a clone+fexecve)
+# ejecutando N trabajos cortos con FCFS.
+#
+# ./bench_launch.sh [N] [slots] [programa]
+#   N         número de trabajos (por defecto 10000)
+#   slots     valor de -j (por defecto 1)
+#   programa  ejecutable a lanzar (por defecto /bin/true)
+
+N=${1:-10000}
+SLOTS=${2:-1}
+PROG=${3:-/bin/true}
+
+FILE=$(mktemp)
+trap 'rm -f "$FILE"' EXIT
+yes "$PROG" | head -n "$N" > "$FILE"
+
+for backend in fork spawn; do
+    start=$(date +%s.%N)
+    stats=$(./scheduler -j "$SLOTS" -l "$backend" FCFS "$FILE" | grep "^Launch backend")
+    end=$(date +%s.%N)
+    echo "$stats"
+    awk -v s="$start" -v e="$end" -v n="$N" -v b="$backend" \
+        'BEGIN { printf "%s: %d jobs in %.3f s (%.0f jobs/s)\n", b, n, e - s, n / (e - s) }'
+done
@@ -0,0 +1,272 @@
+// Benchmark del coste del propio planificador. Emite CSV por stdout:
+//
+//   dispatch_<backend>  desde que se lanza un trabajo hasta la primera
+//                       instrucción de su main (work -t, sin CPU)
+//   preempt             desde kill(SIGSTOP) hasta que el hijo consta parado
+//   resume              desde kill(SIGCONT) hasta que el hijo vuelve a sumar
+//                       CPU en schedstat, sondeado cada 10 us: es una cota
+//                       superior (resolución del sondeo y holgura del timer)
+//   rr_overshoot        cuánto se pasa cada quantum de roundRobin
+//   rr_cpu_per_1000     CPU del planificador por cada 1000 cambios de contexto
+//
+// Las dos últimas barren número de trabajos y quantum con hijos que gastan
+// -c ms de CPU. Los hijos son ../work/work, así que hay que compilarlo antes
+// (make bench lo hace).
+//
+// ./bench_sched [-n jobs,...] [-q quantum_ms,...] [-c cpu_ms] [-s samples]
+//
+// Se compila junto con scheduler.c (sin su main), como bench_jobs, para medir
+// las mismas rutas de lanzamiento y el mismo bucle de eventos. La salida
+// normal del planificador y la de los hijos se descarta.
+#define SCHEDULER_NO_MAIN
+#include "scheduler.c"
+
+#define WORK_ROUTE "../work/work"
+#define MAX_SWEEP 16
+
+FILE *csv;
+
+long long monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Escribe una fila con la distribución de samples (en us)
+void emitRow(const char *metric, int jobs, int quantum, double *samples, int n) {
+    if (n == 0) {
+        return;
+    }
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+    qsort(samples, n, sizeof(double), compareDoubles);
+    fprintf(csv, "%s,%d,%d,%d,%.3f,%.3f,%.3f,%.3f\n", metric, jobs, quantum, n, sum / n,
+            percentile(samples, n, 0.50), percentile(samples, n, 0.95), samples[n - 1]);
+}
+
+// Crea un trabajo para WORK_ROUTE con los argumentos dados
+Process* workJob(const char *args) {
+    char line[256];
+    int len = snprintf(line, sizeof(line), "%s -- %s", WORK_ROUTE, args);
+    Process *p = allocProcess();
+    initJob(p, line, (size_t)len);
+    return p;
+}
+
+void reapJob(Process *p) {
+    waitpid(p->pid, NULL, 0);
+    freeProcess(p);
+}
+
+// Latencia de despacho: el hijo escribe en stderr (una tubería) el instante
+// en que arranca su main
+void benchDispatch(int backend, int samples, double *out) {
+    int pipeFds[2];
+    if (pipe(pipeFds) == -1) {
+        perror("pipe failed");
+        exit(EXIT_FAILURE);
+    }
+    int savedErr = dup(STDERR_FILENO);
+    dup2(pipeFds[1], STDERR_FILENO);
+    close(pipeFds[1]);
+
+    launchBackend = backend;
+    int n = 0;
+    for (int i = 0; i < samples; i++) {
+        Process *p = workJob("-t 0");
+        long long start = monotonicNs();
+        p->pid = launchProcess(p, slots[0].cpu);
+        if (p->pid < 0) {
+            freeProcess(p);
+            break;
+        }
+        char buf[32];
+        ssize_t len = read(pipeFds[0], buf, sizeof(buf) - 1);
+        if (len > 0) {
+            buf[len] = '\0';
+            out[n++] = (atoll(buf) - start) / 1000.0;
+        }
+        reapJob(p);
+    }
+
+    dup2(savedErr, STDERR_FILENO);
+    close(savedErr);
+    close(pipeFds[0]);
+    emitRow(backend == LAUNCH_SPAWN ? "dispatch_spawn" : "dispatch_fork", 1, 0, out, n);
+}
+
+// Latencias de parada y reanudación sobre un hijo que gira sin parar
+void benchStopCont(int samples, double *stopUs, double *contUs) {
+    Process *p = workJob("600000");
+    p->pid = launchProcess(p, slots[0].cpu);
+    if (p->pid < 0) {
+        freeProcess(p);
+        return;
+    }
+    struct timespec run = {0, 2000000}; // Le dejamos correr 2 ms entre medidas
+    int n = 0;
+    for (int i = 0; i < samples; i++) {
+        nanosleep(&run, NULL);
+
+        siginfo_t info;
+        long long start = monotonicNs();
+        kill(p->pid, SIGSTOP);
+        if (waitid(P_PID, p->pid, &info, WSTOPPED) == -1) {
+            break;
+        }
+        stopUs[n] = (monotonicNs() - start) / 1000.0;
+
+        long long cpu = readCpuNs(p->pid);
+        start = monotonicNs();
+        kill(p->pid, SIGCONT);
+        // Dormimos entre sondeos en lugar de ceder con sched_yield: con una
+        // sola CPU el hijo no correría hasta el siguiente tick
+        struct timespec poll = {0, 10000};
+        while (readCpuNs(p->pid) == cpu) {
+            nanosleep(&poll, NULL);
+        }
+        contUs[n++] = (monotonicNs() - start) / 1000.0;
+    }
+    kill(p->pid, SIGKILL);
+    reapJob(p);
+    emitRow("preempt", 1, 0, stopUs, n);
+    emitRow("resume", 1, 0, contUs, n);
+}
+
+// roundRobin real con jobs hijos de cpuMs cada uno
+void benchRoundRobin(int jobs, int quantum, int cpuMs) {
+    char args[32];
+    snprintf(args, sizeof(args), "%d", cpuMs);
+    Queue *q = createQueue();
+    for (int i = 0; i < jobs; i++) {
+        enqueue(q, workJob(args));
+    }
+
+    memset(&switchStats, 0, sizeof(switchStats));
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    roundRobin(q, quantum);
+    getrusage(RUSAGE_SELF, &after);
+    destroyQueue(q);
+
+    double cpuUs = (after.ru_utime.tv_sec - before.ru_utime.tv_sec) * 1e6 +
+                   (after.ru_utime.tv_usec - before.ru_utime.tv_usec) +
+                   (after.ru_stime.tv_sec - before.ru_stime.tv_sec) * 1e6 +
+                   (after.ru_stime.tv_usec - before.ru_stime.tv_usec);
+    if (switchStats.expirations > 0) {
+        fprintf(csv, "rr_overshoot,%d,%d,%ld,%.3f,,,%.3f\n", jobs, quantum,
+                switchStats.expirations, switchStats.overshootUs / switchStats.expirations,
+                switchStats.maxOvershootUs);
+    }
+    if (switchStats.switches > 0) {
+        fprintf(csv, "rr_cpu_per_1000,%d,%d,%ld,%.3f,,,\n", jobs, quantum,
+                switchStats.switches, cpuUs * 1000.0 / switchStats.switches);
+    }
+}
+
+// Lista de enteros positivos separados por comas
+int parseList(const char *s, int *out) {
+    int n = 0;
+    char *end;
+    while (n < MAX_SWEEP) {
+        long v = strtol(s, &end, 10);
+        if (end == s || v <= 0) {
+            return -1;
+        }
+        out[n++] = (int)v;
+        if (*end != ',') {
+            break;
+        }
+        s = end + 1;
+    }
+    return *end == '\0' ? n : -1;
+}
+
+int main(int argc, char **argv) {
+    int jobCounts[MAX_SWEEP] = {2, 8, 32}, numJobCounts = 3;
+    int quanta[MAX_SWEEP] = {2, 10, 50}, numQuanta = 3;
+    int cpuMs = 50, samples = 200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:q:c:s:")) != -1) {
+        if (opt == 'n') {
+            numJobCounts = parseList(optarg, jobCounts);
+        } else if (opt == 'q') {
+            numQuanta = parseList(optarg, quanta);
+        } else if (opt == 'c') {
+            cpuMs = atoi(optarg);
+        } else if (opt == 's') {
+            samples = atoi(optarg);
+        } else {
+            numJobCounts = -1;
+        }
+    }
+    if (numJobCounts <= 0 || numQuanta <= 0 || cpuMs <= 0 || samples <= 0 || optind != argc) {
+        fprintf(stderr, "Usage: %s [-n jobs,...] [-q quantum_ms,...] [-c cpu_ms] [-s samples]\n",
+                argv[0]);
+        return 1;
+    }
+    if (access(WORK_ROUTE, X_OK) != 0) {
+        fprintf(stderr, "%s not found: run 'make -C ../work work' first\n", WORK_ROUTE);
+        return 1;
+    }
+
+    // El CSV va a una copia de stdout; lo que imprimen el planificador y los
+    // hijos se tira
+    csv = fdopen(dup(STDOUT_FILENO), "w");
+    if (!csv || !freopen("/dev/null", "w", stdout)) {
+        perror("Failed to redirect stdout");
+        return 1;
+    }
+    // Calibración de work antes de medir nada, para que no caiga en una ronda
+    if (system(WORK_ROUTE " 1 > /dev/null") != 0) {
+        fprintf(stderr, "%s failed\n", WORK_ROUTE);
+        return 1;
+    }
+
+    startSec = nowSeconds();
+    readyQueue = createQueue();
+    initSlots(1, 0);
+    fprintf(csv, "metric,jobs,quantum_ms,samples,mean_us,p50_us,p95_us,max_us\n");
+
+    double *a = (double*)malloc(samples * sizeof(double));
+    double *b = (double*)malloc(samples * sizeof(double));
+    if (!a || !b) {
+        perror("Failed to allocate samples");
+        return 1;
+    }
+    benchDispatch(LAUNCH_FORK, samples, a);
+    benchDispatch(LAUNCH_SPAWN, samples, a);
+    benchStopCont(samples, a, b);
+    free(a);
+    free(b);
+    fflush(csv);
+
+    // A partir de aquí, el bucle de eventos completo como en main
+    tableInit(64);
+    installSigchldHandler();
+    initEventLoop();
+    heapInit(&pendingArrivals, arrivesBefore);
+    for (int i = 0; i < numJobCounts; i++) {
+        for (int j = 0; j < numQuanta; j++) {
+            benchRoundRobin(jobCounts[i], quanta[j], cpuMs);
+            fflush(csv);
+        }
+    }
+    closeEventLoop();
+    close(sigEventFd);
+
+    heapDestroy(&pendingArrivals);
+    destroyQueue(readyQueue);
+    free(completions.pids);
+    free(completions.procs);
+    free(slots);
+    free(spawnStack);
+    free(metrics);
+    routeCacheFree();
+    destroyPool();
+    fclose(csv);
+    return 0;
+}
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Genera una traza sintética para --simulate: llegadas de Poisson y ráfagas
+# exponenciales. Una parte de los trabajos hace una E/S entre dos ráfagas.
+#
+# ./gen_trace.sh [N] [llegada_ms] [cpu_ms] [io_ms] [prob_io] > traza.txt
+#   N           número de trabajos (por defecto 100000)
+#   llegada_ms  tiempo medio entre llegadas (por defecto 100)
+#   cpu_ms      duración media de una ráfaga de CPU (por defecto 80)
+#   io_ms       duración media de una E/S (por defecto 300)
+#   prob_io     fracción de trabajos con E/S (por defecto 0.3)
+
+N=${1:-100000}
+ARRIVAL=${2:-100}
+CPU=${3:-80}
+IO=${4:-300}
+PIO=${5:-0.3}
+
+awk -v n="$N" -v arr="$ARRIVAL" -v cpu="$CPU" -v io="$IO" -v pio="$PIO" '
+function expo(mean) { return -mean * log(1 - rand()) }
+function ms(mean) { v = int(expo(mean)); return v > 0 ? v : 1 }
+BEGIN {
+    srand(42)
+    t = 0
+    for (i = 0; i < n; i++) {
+        t += expo(arr)
+        if (rand() < pio) {
+            printf "job%d at=%d bursts=%d,%d,%d\n", i % 7 + 1, t, ms(cpu), ms(io), ms(cpu)
+        } else {
+            printf "job%d at=%d bursts=%d\n", i % 7 + 1, t, ms(cpu)
+        }
+    }
+}'
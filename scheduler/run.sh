@@ -7,3 +7,35 @@
 # ./scheduler_io FCFS mixed.txt
 # ./scheduler_io RR 1000 mixed.txt
 
+
+# ./scheduler -j 4 FCFS homogeneous.txt
+# ./scheduler -j 4 RR 1000 reverse.txt
+
+# ./scheduler -l fork FCFS reverse.txt
+# ./bench_launch.sh 10000
+# make bench_jobs && ./bench_jobs 1000000
+# make bench                           (coste del planificador en bench.csv; ./bench_sched -n 4,16 -q 1,5)
+
+# cat reverse.txt | ./scheduler RR 1000 -
+# mkfifo jobs.fifo && ./scheduler -j 4 FCFS jobs.fifo    (echo ../work/work1 > jobs.fifo)
+# ./scheduler RR 1000 unix:/tmp/scheduler.sock
+# ./scheduler -m metrics.json RR 1000 reverse.txt
+# ./scheduler -T trace.json RR 100 reverse.txt   (abrir en https://ui.perfetto.dev o chrome://tracing)
+# ./scheduler -L info RR 10 reverse.txt         (sin los mensajes de cada quantum; también en scheduler_io)
+# ./scheduler -o logs -C 4096 -m metrics.json RR 100 reverse.txt   (salida de cada trabajo en logs/, inicio de stdout en las métricas)
+# ./scheduler -P cgroup RR 100 reverse.txt      (congela la hoja de cgroup v2 de cada trabajo; si no se puede, señales)
+# ./scheduler -m metrics.json RR auto reverse.txt   (quantum reajustado cada 500 ms según las ráfagas; historial en "quanta")
+# ./scheduler -j 4 FCFS pipeline.txt   (líneas "../work/work id=C after=A,B -- 100": C espera a A y B; camino crítico al final)
+# ./scheduler -j 4 -M 2048 RR 100 big.txt   (no lanza lo que no quepa en 2 GB: mem=MB por trabajo o pico aprendido de wait4)
+
+# ./scheduler MLFQ 250,500,1000 5000 reverse.txt
+# ./scheduler SJF reverse.txt          (aprende duraciones en scheduler.history)
+# ./scheduler -H /tmp/hist SRTF reverse.txt
+# ./scheduler FAIR 20 reverse.txt     (líneas "../work/work7 nice=5" para repartir por peso)
+# ./scheduler PRIO 50 jobs.txt         (prio= por trabajo, con envejecimiento; en caliente: echo "!prio JOB N" > fifo)
+# ./scheduler EDF sla.txt             (líneas "../work/work deadline=800 expect=300 -- 300"; rechaza lo que no cabe)
+# ./scheduler -c /tmp/sched.ctl RR 50 jobs.txt   (echo status | socat - UNIX:/tmp/sched.ctl; también running, jobs, metrics, set, add, cancel, prio)
+# ./gen_trace.sh 1000000 150 > trace.txt && ./scheduler --simulate -j 4 RR 50 trace.txt
+# ./scheduler SJF jobs.txt            (formato v2: "ruta at=500 prio=100 expect=200 bursts=50,10,50 -- args")
+# ./scheduler RR 50 calibrated.txt     (líneas "../work/work -- -m cache 100,20,100"; ../work/work -r 0 recalibra)
+# ./scheduler_io RR 50 io.txt          (líneas "../work/work -- -p 100,300,100")
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,43 +9,318 @@
 #include <unistd.h>
 #include <signal.h>
 #include <time.h>
-
-volatile int exit_flag = 0; // Para que el padre en FCFS espere, pero también maneje señales
+#include <sched.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stddef.h>
+#include <math.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <sys/uio.h>
+#include <dirent.h>
 
 typedef enum {
     NEW,
     RUNNING,
     STOPPED,
+    BLOCKED, // En E/S (solo en simulación)
     EXITED
 } ExecutionStatus;
 
 // ------------------ Estructuras ------------------
 
-// Representa un proceso
+// Representa un proceso. Los nombres apuntan a la ruta internada (ver
+// internRoute), así que todos los trabajos con la misma ruta comparten una
+// única copia de la cadena.
 typedef struct Process {
-    char executableName[256]; // Nombre del binario (p.ej. "work7")
-    char route[256];          // Ruta completa (p.ej. "./work/work7")
-    int pid;                  // PID
-    ExecutionStatus status;   // Estado
-    struct timeval entryTime; // Momento en que se encoló
-    int remainingTime;        // Para Round Robin
+    const char *executableName; // Nombre del binario (p.ej. "work7")
+    const char *route;          // Ruta completa (p.ej. "./work/work7")
+    int pid;                    // PID
+    ExecutionStatus status;     // Estado
+    struct timeval entryTime;   // Momento en que se encoló
+    int remainingTime;          // Para Round Robin
+    int pidfd;                  // Descriptor del hijo para epoll (-1 si no lanzado)
+    int slot;                   // Slot que lo ejecuta (-1 si está en la cola)
+    int execFd;                 // Ejecutable pre-abierto para fexecve (backend spawn)
+    long cpuUserUs;             // CPU de usuario según wait4, en microsegundos
+    long cpuSysUs;              // CPU de sistema según wait4, en microsegundos
+    long maxRssKb;              // Pico de memoria residente según wait4
+    double arrivalSec;          // Llegada a la cola (nowSeconds)
+    double readySec;            // Última vez que entró en la cola como listo
+    double firstRunSec;         // Primer despacho (-1 si aún no ha corrido)
+    double waitSec;             // Tiempo total listo en la cola sin ejecutarse
+    int preemptions;            // Veces que se le quitó la CPU
+    int level;                  // Nivel de MLFQ o prioridad efectiva de PRIO (0 = más prioritario)
+    double levelSec;            // Cuándo entró en su nivel actual (envejecimiento de PRIO)
+    double predictedMs;         // Duración esperada según el historial (SJF/SRTF)
+    int ranMs;                  // Tiempo que ha pasado en CPU antes del quantum actual
+    int quantumMs;              // Quantum de su último despacho (0 = sin límite)
+    int nice;                   // -20..19, del fichero de trabajos (FAIR)
+    double vruntime;            // CPU ponderada por el peso del nice, en ms (FAIR)
+    long long cpuNs;            // CPU consumida en la última lectura (FAIR)
+    unsigned phChild;           // Primer hijo en el pairing heap de FAIR
+    unsigned phSibling;         // Siguiente hermano en el pairing heap de FAIR
+    int arrivalMs;              // Llegada relativa al arranque (at=, simulación)
+    int *bursts;                // Ráfagas CPU, E/S, CPU... en ms (bursts=, simulación)
+    int numBursts;
+    int burst;                  // Ráfaga actual (simulación)
+    double burstLeftMs;         // Lo que queda de la ráfaga actual (simulación)
+    double simCpuMs;            // CPU consumida en la simulación
+    int priority;               // 0..139, menor = más urgente (prio=)
+    int deadlineMs;             // Plazo relativo a la llegada (deadline=, 0 = sin plazo)
+    double deadlineSec;         // Plazo absoluto, fijado al admitirlo (EDF)
+    int dagNode;                // Nodo en el grafo de dependencias (-1 = ninguno)
+    int waitingOn;              // Dependencias (after=) que aún no han terminado
+    long memKb;                 // Pico de memoria declarado con mem= (0 = aprenderlo)
+    long reservedKb;            // Memoria que tiene reservada mientras vive (-M)
+    int statmFd;                // /proc/PID/statm abierto para muestrear (-1 = no)
+    char **argv;                // Argumentos tras "--" (NULL = solo el nombre)
+    unsigned id;                // Índice en el pool de procesos
+    unsigned jobNo;             // Número de trabajo en orden de llegada (traza)
+    int cgroupFd;               // Hoja de cgroup del trabajo (-P cgroup; -1 = señales)
+    int outFds[2];              // Lectura de las tuberías de stdout/stderr (-1 = cerrada)
+    int logFds[2];              // Ficheros DIR/<n>-<nombre>.out/.err (-1 = ninguno)
+    char *captured;             // Primeros bytes de stdout (-C), para las métricas
+    size_t capturedLen;
+    unsigned nextFree;          // Siguiente libre cuando está en la lista del pool
 } Process;
 
-// Para usar en FCFS/RR cuando un proceso termina
-Process *terminatedProcess = NULL;
+// Pool de procesos: bloques de POOL_CHUNK_SIZE registros que no se mueven
+// nunca, con lista de libres para reutilizar los de trabajos terminados.
+// Un índice de 32 bits identifica cada registro.
+#define POOL_CHUNK_SHIFT 12
+#define POOL_CHUNK_SIZE (1u << POOL_CHUNK_SHIFT)
+#define POOL_NONE 0xffffffffu
+
+typedef struct ProcessPool {
+    Process **chunks;
+    unsigned numChunks;
+    unsigned chunkCapacity;
+    unsigned used;     // Registros entregados alguna vez (siguiente índice nuevo)
+    unsigned freeList; // Primer registro libre para reutilizar (POOL_NONE si no hay)
+    unsigned live;     // Registros en uso ahora mismo
+} ProcessPool;
 
-// Nodo de la cola
-typedef struct Node {
-    Process *process;
-    struct Node *next;
-} Node;
+ProcessPool pool = {NULL, 0, 0, 0, POOL_NONE, 0};
 
-// Cola para gestionar procesos
+// Registros en uso por estado: un registro recién sacado del pool cuenta
+// como EXITED hasta que initJob lo pone en NEW (ver setStatus)
+unsigned statusCounts[EXITED + 1];
+
+// Cola para gestionar procesos: buffer circular de índices del pool que
+// crece al doble cuando se llena
 typedef struct Queue {
-    Node *front;
-    Node *rear;
+    unsigned *ids;
+    unsigned capacity; // Siempre potencia de 2
+    unsigned head;     // Posición del primero
+    unsigned count;
 } Queue;
 
+// Slot de ejecución: cada uno mantiene como mucho un hijo corriendo
+typedef struct Slot {
+    int cpu;                    // CPU a la que se fija el slot (-1 = sin fijar)
+    Process *proc;              // Proceso en ejecución (NULL si está libre)
+    double sliceStartSec;       // Inicio del quantum actual (nowSeconds)
+    int timerFd;                // timerfd que vence al acabar el quantum
+    int quantum;                // Quantum armado en este despacho (ms)
+    unsigned gen;               // Simulación: invalida los fines de quantum ya planificados
+} Slot;
+
+Slot *slots = NULL;
+int numSlots = 1;
+
+// Dos formas de lanzar un hijo:
+//  - LAUNCH_FORK: fork() + execlp(), como siempre. Copia las tablas de
+//    páginas del planificador, así que cuesta más cuanto mayor es su heap.
+//  - LAUNCH_SPAWN: clone(CLONE_VM | CLONE_VFORK) + fexecve() sobre el fd
+//    pre-abierto. El hijo comparte la memoria del padre hasta el exec, que
+//    queda suspendido mientras tanto (lo mismo que hace posix_spawn), pero
+//    así podemos fijar la CPU y usar fexecve antes del exec.
+typedef enum {
+    LAUNCH_FORK,
+    LAUNCH_SPAWN
+} LaunchBackend;
+
+LaunchBackend launchBackend = LAUNCH_SPAWN;
+
+// ------------------ Pool de procesos ------------------
+
+static inline Process* processAt(unsigned id) {
+    return &pool.chunks[id >> POOL_CHUNK_SHIFT][id & (POOL_CHUNK_SIZE - 1)];
+}
+
+Process* allocProcess() {
+    Process *p;
+    if (pool.freeList != POOL_NONE) {
+        p = processAt(pool.freeList);
+        pool.freeList = p->nextFree;
+    } else {
+        if (pool.used == pool.numChunks * POOL_CHUNK_SIZE) {
+            if (pool.numChunks == pool.chunkCapacity) {
+                unsigned capacity = pool.chunkCapacity ? pool.chunkCapacity * 2 : 16;
+                Process **chunks = (Process**)realloc(pool.chunks, capacity * sizeof(Process*));
+                if (!chunks) {
+                    perror("Failed to allocate memory for process pool");
+                    exit(EXIT_FAILURE);
+                }
+                pool.chunks = chunks;
+                pool.chunkCapacity = capacity;
+            }
+            pool.chunks[pool.numChunks] = (Process*)malloc(POOL_CHUNK_SIZE * sizeof(Process));
+            if (!pool.chunks[pool.numChunks]) {
+                perror("Failed to allocate memory for process pool");
+                exit(EXIT_FAILURE);
+            }
+            pool.numChunks++;
+        }
+        p = processAt(pool.used);
+        p->id = pool.used++;
+    }
+    pool.live++;
+    p->status = EXITED;
+    statusCounts[EXITED]++;
+    return p;
+}
+
+// Índice número de trabajo (jobNo) -> registro del pool de los trabajos
+// vivos. El índice del pool se reutiliza y el PID solo existe tras el
+// lanzamiento; jobNo no cambia y ya lo tiene un trabajo en cola, así que es
+// como se nombran los trabajos desde fuera (!prio, socket de control).
+// Direccionamiento abierto con sondeo lineal, como la tabla de finalización.
+typedef struct JobIndex {
+    unsigned *jobs;
+    unsigned *ids;     // POOL_NONE = hueco libre
+    unsigned capacity; // Siempre potencia de 2
+    unsigned count;
+} JobIndex;
+
+JobIndex jobIndex = {NULL, NULL, 0, 0};
+
+static inline unsigned jobHash(unsigned jobNo, unsigned capacity) {
+    return (jobNo * 2654435761u) & (capacity - 1);
+}
+
+// Pone jobNo en el primer hueco de su sondeo (sin comprobar la ocupación)
+void jobIndexPlace(unsigned jobNo, unsigned id) {
+    unsigned i = jobHash(jobNo, jobIndex.capacity);
+    while (jobIndex.ids[i] != POOL_NONE) {
+        i = (i + 1) & (jobIndex.capacity - 1);
+    }
+    jobIndex.jobs[i] = jobNo;
+    jobIndex.ids[i] = id;
+}
+
+void jobIndexGrow() {
+    JobIndex old = jobIndex;
+    jobIndex.capacity = old.capacity ? old.capacity * 2 : 64;
+    jobIndex.jobs = (unsigned*)malloc(jobIndex.capacity * sizeof(unsigned));
+    jobIndex.ids = (unsigned*)malloc(jobIndex.capacity * sizeof(unsigned));
+    if (!jobIndex.jobs || !jobIndex.ids) {
+        perror("Failed to allocate memory for job index");
+        exit(EXIT_FAILURE);
+    }
+    memset(jobIndex.ids, 0xff, jobIndex.capacity * sizeof(unsigned));
+    for (unsigned i = 0; i < old.capacity; i++) {
+        if (old.ids[i] != POOL_NONE) {
+            jobIndexPlace(old.jobs[i], old.ids[i]);
+        }
+    }
+    free(old.jobs);
+    free(old.ids);
+}
+
+void jobIndexInsert(unsigned jobNo, unsigned id) {
+    if ((jobIndex.count + 1) * 2 > jobIndex.capacity) {
+        jobIndexGrow();
+    }
+    jobIndexPlace(jobNo, id);
+    jobIndex.count++;
+}
+
+// Posición de jobNo en el índice, o -1
+long jobIndexSlot(unsigned jobNo) {
+    if (jobIndex.capacity == 0) {
+        return -1;
+    }
+    unsigned i = jobHash(jobNo, jobIndex.capacity);
+    while (jobIndex.ids[i] != POOL_NONE) {
+        if (jobIndex.jobs[i] == jobNo) {
+            return i;
+        }
+        i = (i + 1) & (jobIndex.capacity - 1);
+    }
+    return -1;
+}
+
+// Trabajo vivo con ese número, o NULL
+Process* findJob(unsigned jobNo) {
+    long i = jobIndexSlot(jobNo);
+    return i < 0 ? NULL : processAt(jobIndex.ids[i]);
+}
+
+// Quita jobNo si apunta al registro id (un registro nunca inicializado trae
+// un jobNo viejo que ya no está o es de otro)
+void jobIndexRemove(unsigned jobNo, unsigned id) {
+    long at = jobIndexSlot(jobNo);
+    if (at < 0 || jobIndex.ids[at] != id) {
+        return;
+    }
+    // Borrado con desplazamiento hacia atrás, como en tableRemove
+    unsigned mask = jobIndex.capacity - 1;
+    unsigned i = (unsigned)at, j = i;
+    while (1) {
+        jobIndex.ids[i] = POOL_NONE;
+        while (1) {
+            j = (j + 1) & mask;
+            if (jobIndex.ids[j] == POOL_NONE) {
+                jobIndex.count--;
+                return;
+            }
+            unsigned k = jobHash(jobIndex.jobs[j], jobIndex.capacity);
+            if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+                break;
+            }
+        }
+        jobIndex.jobs[i] = jobIndex.jobs[j];
+        jobIndex.ids[i] = jobIndex.ids[j];
+        i = j;
+    }
+}
+
+void freeProcess(Process *p) {
+    jobIndexRemove(p->jobNo, p->id);
+    free(p->captured);
+    p->captured = NULL;
+    free(p->bursts);
+    p->bursts = NULL;
+    free(p->argv);
+    p->argv = NULL;
+    p->nextFree = pool.freeList;
+    pool.freeList = p->id;
+    pool.live--;
+    statusCounts[p->status]--;
+}
+
+void destroyPool() {
+    for (unsigned i = 0; i < pool.numChunks; i++) {
+        free(pool.chunks[i]);
+    }
+    free(pool.chunks);
+    free(jobIndex.jobs);
+    free(jobIndex.ids);
+}
+
 // ------------------ Funciones de cola ------------------
 
 Queue* createQueue() {
@@ -53,30 +329,44 @@ Queue* createQueue() {
         perror("Failed to allocate memory for queue");
         exit(EXIT_FAILURE);
     }
-    q->front = NULL;
-    q->rear = NULL;
+    q->capacity = 64;
+    q->ids = (unsigned*)malloc(q->capacity * sizeof(unsigned));
+    if (q->ids == NULL) {
+        perror("Failed to allocate memory for queue");
+        exit(EXIT_FAILURE);
+    }
+    q->head = 0;
+    q->count = 0;
     return q;
 }
 
+void destroyQueue(Queue *q) {
+    free(q->ids);
+    free(q);
+}
+
 int isQueueEmpty(Queue *q) {
-    return (q->front == NULL);
+    return (q->count == 0);
 }
 
 void enqueue(Queue *q, Process* p) {
-    Node *newNode = (Node*)malloc(sizeof(Node));
-    if (!newNode) {
-        perror("Memory allocation error");
-        exit(EXIT_FAILURE);
-    }
-    newNode->process = p;
-    newNode->next = NULL;
-
-    if (isQueueEmpty(q)) {
-        q->front = q->rear = newNode;
-    } else {
-        q->rear->next = newNode;
-        q->rear = newNode;
+    if (q->count == q->capacity) {
+        // Duplicamos y desenrollamos el anillo al principio del nuevo buffer
+        unsigned *ids = (unsigned*)malloc(q->capacity * 2 * sizeof(unsigned));
+        if (!ids) {
+            perror("Memory allocation error");
+            exit(EXIT_FAILURE);
+        }
+        unsigned first = q->capacity - q->head;
+        memcpy(ids, q->ids + q->head, first * sizeof(unsigned));
+        memcpy(ids + first, q->ids, q->head * sizeof(unsigned));
+        free(q->ids);
+        q->ids = ids;
+        q->head = 0;
+        q->capacity *= 2;
     }
+    q->ids[(q->head + q->count) & (q->capacity - 1)] = p->id;
+    q->count++;
 }
 
 Process* dequeue(Queue *q) {
@@ -84,25 +374,139 @@ Process* dequeue(Queue *q) {
         fprintf(stderr, "Error: Queue is empty\n");
         exit(EXIT_FAILURE);
     }
-    Node *temp = q->front;
-    Process *p = temp->process;
-    q->front = q->front->next;
-    if (q->front == NULL) {
-        q->rear = NULL;
-    }
-    free(temp);
+    Process *p = processAt(q->ids[q->head]);
+    q->head = (q->head + 1) & (q->capacity - 1);
+    q->count--;
     return p;
 }
 
+Process* queueFront(Queue *q) {
+    return processAt(q->ids[q->head]);
+}
+
+// Saca p de en medio de la cola, O(n). Devuelve 0 si no estaba.
+int queueRemove(Queue *q, Process *p) {
+    unsigned mask = q->capacity - 1;
+    for (unsigned i = 0; i < q->count; i++) {
+        if (q->ids[(q->head + i) & mask] != p->id) {
+            continue;
+        }
+        for (; i + 1 < q->count; i++) {
+            q->ids[(q->head + i) & mask] = q->ids[(q->head + i + 1) & mask];
+        }
+        q->count--;
+        return 1;
+    }
+    return 0;
+}
+
+// ------------------ Montículo de procesos ------------------
+
+// Montículo binario de índices del pool ordenado por el criterio de la
+// política (less). Push y pop son O(log n) aunque la cola sea enorme.
+typedef struct Heap {
+    unsigned *ids;
+    unsigned capacity;
+    unsigned count;
+    int (*less)(Process *a, Process *b); // ¿a sale antes que b?
+} Heap;
+
+void heapInit(Heap *h, int (*less)(Process *a, Process *b)) {
+    h->capacity = 64;
+    h->ids = (unsigned*)malloc(h->capacity * sizeof(unsigned));
+    if (h->ids == NULL) {
+        perror("Failed to allocate memory for heap");
+        exit(EXIT_FAILURE);
+    }
+    h->count = 0;
+    h->less = less;
+}
+
+void heapDestroy(Heap *h) {
+    while (h->count > 0) {
+        freeProcess(processAt(h->ids[--h->count]));
+    }
+    free(h->ids);
+    h->ids = NULL;
+}
+
+static inline int heapLess(Heap *h, unsigned i, unsigned j) {
+    return h->less(processAt(h->ids[i]), processAt(h->ids[j]));
+}
+
+static inline void heapSwap(Heap *h, unsigned i, unsigned j) {
+    unsigned tmp = h->ids[i];
+    h->ids[i] = h->ids[j];
+    h->ids[j] = tmp;
+}
+
+void heapPush(Heap *h, Process *p) {
+    if (h->count == h->capacity) {
+        unsigned *ids = (unsigned*)realloc(h->ids, h->capacity * 2 * sizeof(unsigned));
+        if (!ids) {
+            perror("Memory allocation error");
+            exit(EXIT_FAILURE);
+        }
+        h->ids = ids;
+        h->capacity *= 2;
+    }
+    unsigned i = h->count++;
+    h->ids[i] = p->id;
+    while (i > 0 && heapLess(h, i, (i - 1) / 2)) {
+        heapSwap(h, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+Process* heapTop(Heap *h) {
+    return h->count > 0 ? processAt(h->ids[0]) : NULL;
+}
+
+Process* heapPop(Heap *h) {
+    if (h->count == 0) {
+        fprintf(stderr, "Error: Heap is empty\n");
+        exit(EXIT_FAILURE);
+    }
+    Process *top = processAt(h->ids[0]);
+    h->ids[0] = h->ids[--h->count];
+    unsigned i = 0;
+    for (;;) {
+        unsigned l = 2 * i + 1, r = l + 1, min = i;
+        if (l < h->count && heapLess(h, l, min)) {
+            min = l;
+        }
+        if (r < h->count && heapLess(h, r, min)) {
+            min = r;
+        }
+        if (min == i) {
+            break;
+        }
+        heapSwap(h, i, min);
+        i = min;
+    }
+    return top;
+}
+
 // ------------------ Funciones auxiliares ------------------
 
-void extractExecutableName(const char *path, char *executableName) {
-    const char *lastSlash = strrchr(path, '/');
-    if (lastSlash) {
-        strcpy(executableName, lastSlash + 1);
-    } else {
-        strcpy(executableName, path);
+// En modo simulación (--simulate) no se lanza nada y el tiempo es virtual
+int simulating = 0;
+double simNow = 0; // Reloj virtual en segundos
+
+// Segundos en reloj monotónico (para métricas; no depende de la hora del
+// sistema). Al simular devuelve el reloj virtual.
+double nowSeconds() {
+    if (simulating) {
+        return simNow;
     }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Milisegundos transcurridos desde startSec (un valor de nowSeconds)
+int elapsedMs(double startSec) {
+    return (int)((nowSeconds() - startSec) * 1000);
 }
 
 double timeval_diff(struct timeval *start, struct timeval *end) {
@@ -116,290 +520,4979 @@ double timeval_diff(struct timeval *start, struct timeval *end) {
     return sec + usec / 1000000.0;
 }
 
-// Carga procesos desde un archivo
-void loadProcessesFromFile(const char *filename, Queue *q) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("Failed to open file");
-        exit(EXIT_FAILURE);
+// Contenido de una cadena JSON (sin las comillas), con comillas, barras y
+// caracteres de control escapados
+void writeJsonChars(FILE *f, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c == '\n') {
+            fputs("\\n", f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
     }
+}
 
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        line[strcspn(line, "\n")] = '\0';  // Quitar el salto de línea
+void writeJsonString(FILE *f, const char *s, size_t len) {
+    fputc('"', f);
+    writeJsonChars(f, s, len);
+    fputc('"', f);
+}
 
-        Process *newProcess = (Process*)malloc(sizeof(Process));
-        if (!newProcess) {
-            perror("Failed to allocate memory for process");
-            fclose(file);
-            exit(EXIT_FAILURE);
+// Campo CSV entre comillas, con las comillas internas dobladas (RFC 4180)
+void writeCsvString(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s != '\0'; s++) {
+        if (*s == '"') {
+            fputc('"', f);
         }
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
 
-        // route contendrá algo como "./work/work7"
-        strcpy(newProcess->route, line);
-        // extraer solo "work7"
-        extractExecutableName(line, newProcess->executableName);
+// ------------------ Registro ------------------
+
+// Los mensajes no pasan por stdio: cada uno se formatea en un registro de
+// tamaño fijo de un anillo preasignado y logFlush los escribe todos con un
+// solo writev. El bucle de eventos vacía el anillo antes de bloquearse, así
+// que nada se queda retenido mientras se espera. Los handlers de señales no
+// registran nada; solo apuntan en childRing.
+typedef enum {
+    LOG_ERROR, // Avisos
+    LOG_INFO,  // Un mensaje por trabajo y los resúmenes
+    LOG_DEBUG  // Un mensaje por quantum (Pausing, Resuming, Enqueued)
+} LogLevel;
+
+#define LOG_RECORD_SIZE 512
+#define LOG_RING_SIZE 256 // Registros por writev (menor que IOV_MAX)
 
-        newProcess->pid = -1;
-        newProcess->status = NEW;
-        gettimeofday(&newProcess->entryTime, NULL);
-        newProcess->remainingTime = 0; // Por defecto
+LogLevel logLevel = LOG_DEBUG;
+char logText[LOG_RING_SIZE][LOG_RECORD_SIZE];
+struct iovec logIov[LOG_RING_SIZE];
+int logCount = 0;
 
-        enqueue(q, newProcess);
-        printf("Enqueued process: %s\n", newProcess->executableName);
+void logFlush() {
+    struct iovec *iov = logIov;
+    int n = logCount;
+    while (n > 0) {
+        ssize_t w = writev(STDOUT_FILENO, iov, n);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // stdout cerrado: se pierde, como con printf
+        }
+        // Escritura parcial: saltamos lo ya escrito
+        while (n > 0 && (size_t)w >= iov->iov_len) {
+            w -= (ssize_t)iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char*)iov->iov_base + w;
+            iov->iov_len -= (size_t)w;
+        }
     }
+    logCount = 0;
+}
 
-    fclose(file);
+__attribute__((format(printf, 2, 3)))
+void logMsg(LogLevel level, const char *fmt, ...) {
+    if (level > logLevel) {
+        return;
+    }
+    if (logCount == LOG_RING_SIZE) {
+        logFlush();
+    }
+    char *text = logText[logCount];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(text, LOG_RECORD_SIZE, fmt, ap);
+    va_end(ap);
+    if (len < 0) {
+        return;
+    }
+    if (len >= LOG_RECORD_SIZE) {
+        // Truncado: conservamos el salto de línea final
+        len = LOG_RECORD_SIZE - 1;
+        text[len - 1] = '\n';
+    }
+    logIov[logCount].iov_base = text;
+    logIov[logCount].iov_len = (size_t)len;
+    logCount++;
 }
 
-// ------------------ Handler de SIGCHLD ------------------
+// ------------------ Traza de estados ------------------
 
-void sigchld_handler(int signo) {
-    (void)signo;
-    if (terminatedProcess == NULL) {
-        // A veces puede llegar SIGCHLD sin que hayamos asignado terminatedProcess
-        // en FCFS, etc. Depende de la lógica. Lo ignoramos.
-        return;
+// Con -T cada cambio de ExecutionStatus se apunta en un anillo en memoria
+// (sin llamadas al sistema: clock_gettime va por vDSO) y al terminar se
+// vuelca como JSON de trace events de Chrome, que abren chrome://tracing y
+// Perfetto. Si el anillo se llena se pisan los registros más antiguos.
+#define TRACE_RING_SIZE (1u << 20) // Registros; siempre potencia de 2
+
+typedef struct TraceRecord {
+    uint64_t ns;       // CLOCK_MONOTONIC (reloj virtual al simular)
+    const char *name;  // executableName: es la ruta internada, no se libera
+    uint32_t job;      // jobNo
+    int16_t slot;      // Slot en el que estaba (-1 = ninguno)
+    uint8_t status;
+} TraceRecord;
+
+TraceRecord *traceRing = NULL;
+uint64_t traceCount = 0; // Registros apuntados desde el inicio
+uint64_t traceStartNs = 0;
+unsigned jobsSeen = 0;   // Siguiente jobNo
+
+static inline uint64_t traceNowNs() {
+    if (simulating) {
+        return (uint64_t)(simNow * 1e9);
     }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
 
-    struct timeval finishTime;
-    gettimeofday(&finishTime, NULL);
+void traceInit() {
+    traceRing = (TraceRecord*)malloc(TRACE_RING_SIZE * sizeof(TraceRecord));
+    if (!traceRing) {
+        perror("Failed to allocate trace ring");
+        exit(EXIT_FAILURE);
+    }
+    traceStartNs = traceNowNs();
+}
 
-    double totalTime = timeval_diff(&terminatedProcess->entryTime, &finishTime);
-    int status;
-    // Esperar al proceso que terminó
-    waitpid(terminatedProcess->pid, &status, 0);
-    terminatedProcess->status = EXITED;
+// Todo cambio de estado pasa por aquí
+static inline void setStatus(Process *p, ExecutionStatus status) {
+    statusCounts[p->status]--;
+    statusCounts[status]++;
+    p->status = status;
+    if (traceRing != NULL) {
+        TraceRecord *r = &traceRing[traceCount++ & (TRACE_RING_SIZE - 1)];
+        r->ns = traceNowNs();
+        r->name = p->executableName;
+        r->job = p->jobNo;
+        r->slot = (int16_t)p->slot;
+        r->status = (uint8_t)status;
+    }
+}
 
-    // Mensajes de estilo FCFS
-    printf("-----------------------------------------------------\n");
-    printf("Process %d finished with code: %d\n", terminatedProcess->pid, WEXITSTATUS(status));
-    printf("Executable: %s\n", terminatedProcess->executableName);
-    printf("Route: %s\n", terminatedProcess->route);
-    printf("Time to execute: %.6f\n", totalTime);
-    printf("-----------------------------------------------------\n");
+const char *statusNames[] = {"NEW", "RUNNING", "STOPPED", "BLOCKED (I/O)", "EXITED"};
 
-    terminatedProcess = NULL;
-    exit_flag = 1;
+// Un tramo "X" en la pista tid del grupo pid
+void traceSpan(FILE *f, int *first, int pid, unsigned tid, const char *name,
+               uint64_t from, uint64_t to) {
+    fprintf(f, "%s{\"ph\": \"X\", \"pid\": %d, \"tid\": %u, \"name\": ",
+            *first ? "" : ",\n", pid, tid);
+    writeJsonString(f, name, strlen(name));
+    fprintf(f, ", \"ts\": %.3f, \"dur\": %.3f}",
+            (from - traceStartNs) / 1000.0, (to - from) / 1000.0);
+    *first = 0;
 }
 
-// ------------------ FCFS ------------------
+void traceTrackName(FILE *f, int *first, int pid, unsigned tid, const char *name, unsigned n) {
+    fprintf(f, "%s{\"ph\": \"M\", \"pid\": %d, \"tid\": %u, \"name\": \"thread_name\", "
+               "\"args\": {\"name\": \"",
+            *first ? "" : ",\n", pid, tid);
+    writeJsonChars(f, name, strlen(name));
+    fprintf(f, " %u\"}}", n);
+    *first = 0;
+}
 
-void firstComeFirstServe(Queue* processes) {
-    Process* currentProc;
-    while (!isQueueEmpty(processes)) {
-        exit_flag = 0;
-        currentProc = dequeue(processes);
-        terminatedProcess = currentProc;
+// Vuelca el anillo: grupo 1 con una pista por slot (qué trabajo corre) y
+// grupo 2 con una pista por trabajo (en qué estado está)
+void writeTrace(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror("Failed to open trace file");
+        return;
+    }
+    uint64_t begin = traceCount > TRACE_RING_SIZE ? traceCount - TRACE_RING_SIZE : 0;
+    unsigned minJob = UINT32_MAX, maxJob = 0;
+    int maxSlot = -1;
+    for (uint64_t i = begin; i < traceCount; i++) {
+        TraceRecord *r = &traceRing[i & (TRACE_RING_SIZE - 1)];
+        minJob = r->job < minJob ? r->job : minJob;
+        maxJob = r->job > maxJob ? r->job : maxJob;
+        maxSlot = r->slot > maxSlot ? r->slot : maxSlot;
+    }
 
-        pid_t pid = fork();
-        if (pid < 0) {
-            perror("Fork failed");
-            free(currentProc);
+    int first = 1;
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(f, "{\"ph\": \"M\", \"pid\": 1, \"name\": \"process_name\", \"args\": {\"name\": \"slots\"}},\n");
+    fprintf(f, "{\"ph\": \"M\", \"pid\": 2, \"name\": \"process_name\", \"args\": {\"name\": \"jobs\"}}");
+    first = 0;
+    for (int i = 0; i <= maxSlot; i++) {
+        traceTrackName(f, &first, 1, (unsigned)i, "slot", (unsigned)i);
+    }
+
+    // Último registro de cada trabajo: el tramo va de él al siguiente
+    TraceRecord **last = NULL;
+    if (traceCount > begin) {
+        last = (TraceRecord**)calloc((size_t)(maxJob - minJob) + 1, sizeof(TraceRecord*));
+        if (!last) {
+            perror("Failed to allocate trace index");
+            fclose(f);
             return;
-        } else if (pid == 0) {
-            // Hijo
-            currentProc->pid = getpid();
-            currentProc->status = RUNNING;
-            // Llamamos con la ruta p->route y nombre p->executableName
-            execlp(currentProc->route, currentProc->executableName, NULL);
-            perror("Execution failed");
-            exit_flag = 1;
-            exit(EXIT_FAILURE);
+        }
+    }
+    uint64_t endNs = traceStartNs;
+    for (uint64_t i = begin; i < traceCount; i++) {
+        TraceRecord *r = &traceRing[i & (TRACE_RING_SIZE - 1)];
+        TraceRecord **prev = &last[r->job - minJob];
+        if (*prev == NULL) {
+            traceTrackName(f, &first, 2, r->job, r->name, r->job);
         } else {
-            // Padre: espera a que termine
-            while (exit_flag == 0) {
-                pause();
+            traceSpan(f, &first, 2, r->job, statusNames[(*prev)->status], (*prev)->ns, r->ns);
+            if ((*prev)->status == RUNNING && (*prev)->slot >= 0) {
+                traceSpan(f, &first, 1, (unsigned)(*prev)->slot, r->name, (*prev)->ns, r->ns);
+            }
+        }
+        *prev = r;
+        endNs = r->ns;
+    }
+    // Los que no han terminado (p.ej. si se cortó la ejecución) llegan al final
+    for (unsigned j = 0; last != NULL && j <= maxJob - minJob; j++) {
+        TraceRecord *r = last[j];
+        if (r != NULL && r->status != EXITED && r->ns < endNs) {
+            traceSpan(f, &first, 2, r->job, statusNames[r->status], r->ns, endNs);
+            if (r->status == RUNNING && r->slot >= 0) {
+                traceSpan(f, &first, 1, (unsigned)r->slot, r->name, r->ns, endNs);
             }
         }
     }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    free(last);
+    logMsg(LOG_INFO, "Trace of %llu transitions written to %s (%llu dropped)\n",
+           (unsigned long long)(traceCount - begin), path, (unsigned long long)begin);
 }
 
-// ------------------ Round Robin ------------------
+// ------------------ Rutas internadas ------------------
 
-void roundRobin(Queue* q, int quantum) {
-    while (!isQueueEmpty(q)) {
-        Process* p = dequeue(q);
-        if (!p) {
-            continue;
+// Cada ruta distinta del fichero de trabajos se guarda una sola vez: los
+// procesos apuntan a esta copia (route y executableName). Con el backend
+// spawn el ejecutable además se abre aquí una única vez y el fd se reutiliza
+// en todos los lanzamientos con fexecve. Tabla hash con sondeo lineal.
+typedef struct RouteEntry {
+    char *route;      // NULL = hueco libre
+    const char *name; // Nombre del binario, dentro de route
+    int fd;           // -1 si no se abrió (fork, o no existe: el hijo fallará)
+} RouteEntry;
+
+typedef struct RouteCache {
+    RouteEntry *entries;
+    int capacity; // Siempre potencia de 2
+    int count;
+} RouteCache;
+
+RouteCache routeCache = {NULL, 0, 0};
+
+unsigned stringHash(const char *s, size_t len) {
+    unsigned h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// La clave son los len bytes de route, que no tiene por qué acabar en '\0'
+RouteEntry* routeSlot(RouteEntry *entries, int capacity, const char *route, size_t len) {
+    unsigned mask = (unsigned)(capacity - 1);
+    unsigned i = stringHash(route, len) & mask;
+    while (entries[i].route != NULL &&
+           (strncmp(entries[i].route, route, len) != 0 || entries[i].route[len] != '\0')) {
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
+
+void routeCacheGrow() {
+    int capacity = routeCache.capacity ? routeCache.capacity * 2 : 16;
+    RouteEntry *entries = (RouteEntry*)calloc(capacity, sizeof(RouteEntry));
+    if (!entries) {
+        perror("Failed to allocate memory for route cache");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < routeCache.capacity; i++) {
+        if (routeCache.entries[i].route != NULL) {
+            const char *route = routeCache.entries[i].route;
+            *routeSlot(entries, capacity, route, strlen(route)) = routeCache.entries[i];
         }
+    }
+    free(routeCache.entries);
+    routeCache.entries = entries;
+    routeCache.capacity = capacity;
+}
 
-        // Si no se ha iniciado nunca, lo lanzamos
-        if (p->pid == -1) {
-            if (p->remainingTime <= 0) {
-                p->remainingTime = 5000; // Ej. 5s
-            }
-            pid_t pid = fork();
-            if (pid < 0) {
-                perror("fork failed");
-                free(p);
-                continue;
-            } else if (pid == 0) {
-                // Hijo
-                p->pid = getpid();
-                p->status = RUNNING;
-                execlp(p->route, p->executableName, NULL);
-                perror("execlp failed");
-                exit(EXIT_FAILURE);
-            } else {
-                // Padre
-                p->pid = pid;
-                p->status = RUNNING;
-                printf("Started process: %s (PID: %d)\n", p->executableName, p->pid);
-            }
-        } else {
-            // Ya existía
-            printf("Resuming process: %s (PID: %d)\n", p->executableName, p->pid);
-            kill(p->pid, SIGCONT);
-            p->status = RUNNING;
-        }
-
-        // Esperamos quantum (simulado) revisando periódicamente
-        struct timespec start, now;
-        clock_gettime(CLOCK_MONOTONIC, &start);
-
-        int elapsed = 0;
-        int finished = 0;
-
-        while (elapsed < quantum) {
-            // Dormimos 1ms
-            struct timespec ts = {0, 1000000L};
-            nanosleep(&ts, NULL);
-
-            clock_gettime(CLOCK_MONOTONIC, &now);
-            elapsed = (int)((now.tv_sec - start.tv_sec) * 1000 +
-                            (now.tv_nsec - start.tv_nsec) / 1000000);
-
-            // Comprobamos si ya terminó
-            int status;
-            pid_t res = waitpid(p->pid, &status, WNOHANG);
-            if (res > 0) {
-                // El proceso terminó o cambió de estado
-                // Imitamos la misma salida que FCFS
-                struct timeval finishTime;
-                gettimeofday(&finishTime, NULL);
-                double totalTime = timeval_diff(&p->entryTime, &finishTime);
-
-                printf("-----------------------------------------------------\n");
-                printf("Process %d finished with code: %d\n", p->pid, WEXITSTATUS(status));
-                printf("Executable: %s\n", p->executableName);
-                printf("Route: %s\n", p->route);
-                printf("Time to execute: %.6f\n", totalTime);
-                printf("-----------------------------------------------------\n");
-
-                free(p);
-                p = NULL;
-                finished = 1;
-                break;
-            }
+// Devuelve la entrada de la ruta, creándola la primera vez que aparece
+RouteEntry* internRoute(const char *route, size_t len) {
+    if ((routeCache.count + 1) * 2 > routeCache.capacity) {
+        routeCacheGrow();
+    }
+    RouteEntry *e = routeSlot(routeCache.entries, routeCache.capacity, route, len);
+    if (e->route == NULL) {
+        e->route = strndup(route, len);
+        if (!e->route) {
+            perror("Failed to allocate memory for route");
+            exit(EXIT_FAILURE);
         }
+        // extraer solo "work7"
+        const char *lastSlash = strrchr(e->route, '/');
+        e->name = lastSlash ? lastSlash + 1 : e->route;
+        e->fd = (launchBackend == LAUNCH_SPAWN) ? open(e->route, O_RDONLY | O_CLOEXEC) : -1;
+        routeCache.count++;
+    }
+    return e;
+}
 
-        // Si no terminó, pausamos
-        if (!finished && p != NULL) {
-            // Verificamos una última vez
-            int status;
-            pid_t res = waitpid(p->pid, &status, WNOHANG);
-            if (res > 0) {
-                // Terminó justo al final
-                struct timeval finishTime;
-                gettimeofday(&finishTime, NULL);
-                double totalTime = timeval_diff(&p->entryTime, &finishTime);
+void routeCacheFree() {
+    for (int i = 0; i < routeCache.capacity; i++) {
+        if (routeCache.entries[i].route != NULL) {
+            if (routeCache.entries[i].fd >= 0) {
+                close(routeCache.entries[i].fd);
+            }
+            free(routeCache.entries[i].route);
+        }
+    }
+    free(routeCache.entries);
+}
 
-                printf("-----------------------------------------------------\n");
-                printf("Process %d finished with code: %d\n", p->pid, WEXITSTATUS(status));
-                printf("Executable: %s\n", p->executableName);
-                printf("Route: %s\n", p->route);
-                printf("Time to execute: %.6f\n", totalTime);
-                printf("-----------------------------------------------------\n");
+// ------------------ Historial de duraciones ------------------
 
-                free(p);
-                p = NULL;
-                continue;
-            }
+// Predicción de la duración de cada ejecutable (SJF/SRTF): media móvil
+// exponencial de la CPU que consumieron sus ejecuciones anteriores. Se
+// guarda en historyPath al terminar y se vuelve a leer en la siguiente
+// ejecución del planificador. Una línea por ejecutable: "nombre ema_ms n".
+#define HISTORY_ALPHA 0.5          // Peso de la última ejecución
+#define DEFAULT_PREDICTION_MS 1000 // Si no hay historial de ningún ejecutable
 
-            // Aún sigue corriendo, lo pausamos
-            printf("Pausing process: %s (PID: %d)\n", p->executableName, p->pid);
-            kill(p->pid, SIGSTOP);
-            p->status = STOPPED;
+typedef struct HistoryEntry {
+    char *name;   // NULL = hueco libre
+    double emaMs; // Predicción actual
+    unsigned samples;
+} HistoryEntry;
 
-            // Descontamos su quantum
-            p->remainingTime -= quantum;
-            if (p->remainingTime > 0) {
-                // Volvemos a encolarlo
-                enqueue(q, p);
-            } else {
-                // Se agotó su tiempo total, lo matamos y mostramos info
-                kill(p->pid, SIGKILL);
-                waitpid(p->pid, NULL, 0);
+typedef struct History {
+    HistoryEntry *entries;
+    int capacity; // Siempre potencia de 2
+    int count;
+    double sumMs; // Suma de las predicciones, para los ejecutables nuevos
+} History;
 
-                struct timeval finishTime;
-                gettimeofday(&finishTime, NULL);
-                double totalTime = timeval_diff(&p->entryTime, &finishTime);
+History history = {NULL, 0, 0, 0};
+const char *historyPath = NULL; // NULL = no se aprende ni se guarda nada
 
-                printf("-----------------------------------------------------\n");
-                printf("Process %d finished with code: %d\n", p->pid, 0); // 0 = Killed?
-                printf("Executable: %s\n", p->executableName);
-                printf("Route: %s\n", p->route);
-                printf("Time to execute: %.6f\n", totalTime);
-                printf("-----------------------------------------------------\n");
+HistoryEntry* historySlot(HistoryEntry *entries, int capacity, const char *name) {
+    unsigned mask = (unsigned)(capacity - 1);
+    unsigned i = stringHash(name, strlen(name)) & mask;
+    while (entries[i].name != NULL && strcmp(entries[i].name, name) != 0) {
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
 
-                free(p);
-                p = NULL;
-            }
+void historyGrow() {
+    int capacity = history.capacity ? history.capacity * 2 : 16;
+    HistoryEntry *entries = (HistoryEntry*)calloc(capacity, sizeof(HistoryEntry));
+    if (!entries) {
+        perror("Failed to allocate memory for history");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < history.capacity; i++) {
+        if (history.entries[i].name != NULL) {
+            *historySlot(entries, capacity, history.entries[i].name) = history.entries[i];
         }
     }
+    free(history.entries);
+    history.entries = entries;
+    history.capacity = capacity;
 }
 
-// ------------------ main ------------------
-
-int main(int argc, char **argv) {
-    // Validaciones mínimas
-    if (argc < 2) {
-        printf("Usage: %s <policy> [quantum] <filename>\n", argv[0]);
-        return 1;
+HistoryEntry* historyFind(const char *name) {
+    if (history.count == 0) {
+        return NULL;
     }
+    HistoryEntry *e = historySlot(history.entries, history.capacity, name);
+    return e->name != NULL ? e : NULL;
+}
 
-    char *policy = argv[1];
-    if (strcmp(policy, "FCFS") != 0 && strcmp(policy, "RR") != 0) {
-        printf("Invalid policy name. Use 'FCFS' or 'RR'.\n");
-        return 1;
+// Mezcla una nueva observación de name en su media
+void historyUpdate(const char *name, double ms, unsigned samples) {
+    if ((history.count + 1) * 2 > history.capacity) {
+        historyGrow();
     }
-
-    if (strcmp(policy, "RR") == 0 && argc != 4) {
-        printf("Usage for RR: %s RR <quantum> <filename>\n", argv[0]);
-        return 1;
+    HistoryEntry *e = historySlot(history.entries, history.capacity, name);
+    if (e->name == NULL) {
+        e->name = strdup(name);
+        if (!e->name) {
+            perror("Failed to allocate memory for history");
+            exit(EXIT_FAILURE);
+        }
+        e->emaMs = ms;
+        e->samples = 0;
+        history.count++;
+    } else {
+        history.sumMs -= e->emaMs;
+        e->emaMs = HISTORY_ALPHA * ms + (1 - HISTORY_ALPHA) * e->emaMs;
     }
-    if (strcmp(policy, "FCFS") == 0 && argc != 3) {
-        printf("Usage for FCFS: %s FCFS <filename>\n", argv[0]);
-        return 1;
+    history.sumMs += e->emaMs;
+    e->samples += samples;
+}
+
+// Duración esperada de name en ms. Un ejecutable sin historial recibe la
+// media de los conocidos.
+double predictRuntime(const char *name) {
+    HistoryEntry *e = historyFind(name);
+    if (e != NULL) {
+        return e->emaMs;
     }
+    return history.count > 0 ? history.sumMs / history.count : DEFAULT_PREDICTION_MS;
+}
 
-    // Creamos la cola y asignamos handler
-    Queue* processQueue = createQueue();
-    signal(SIGCHLD, sigchld_handler);
+// Aprende de un proceso que ha terminado solo (no de los que matamos)
+void learnRuntime(Process *p) {
+    if (historyPath == NULL) {
+        return;
+    }
+    historyUpdate(p->executableName, (p->cpuUserUs + p->cpuSysUs) / 1000.0, 1);
+}
 
-    if (strcmp(policy, "RR") == 0) {
-        int quantum = atoi(argv[2]);
-        if (quantum <= 0) {
-            printf("Invalid quantum value. Must be positive.\n");
-            return 1;
+void loadHistory(const char *path) {
+    historyPath = path;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return; // Primera ejecución: aún no hay historial
+    }
+    char name[256];
+    double ms;
+    unsigned samples;
+    while (fscanf(f, "%255s %lf %u", name, &ms, &samples) == 3) {
+        if (historyFind(name) == NULL) {
+            historyUpdate(name, ms, samples);
         }
-        char *filename = argv[3];
-        loadProcessesFromFile(filename, processQueue);
-        roundRobin(processQueue, quantum);
-    } else {
-        // FCFS
-        char *filename = argv[2];
-        loadProcessesFromFile(filename, processQueue);
-        firstComeFirstServe(processQueue);
     }
+    fclose(f);
+}
 
-    // Liberamos la cola
-    while (!isQueueEmpty(processQueue)) {
-        Process* p = dequeue(processQueue);
-        free(p);
+// Se escribe a un temporal y se renombra para no dejar el fichero a medias
+void saveHistory() {
+    if (historyPath == NULL) {
+        return;
+    }
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", historyPath);
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        perror("Failed to open history file");
+        return;
     }
-    free(processQueue);
+    for (int i = 0; i < history.capacity; i++) {
+        HistoryEntry *e = &history.entries[i];
+        if (e->name != NULL) {
+            fprintf(f, "%s %.3f %u\n", e->name, e->emaMs, e->samples);
+        }
+    }
+    if (fclose(f) != 0 || rename(tmp, historyPath) != 0) {
+        perror("Failed to write history file");
+    }
+}
 
-    return 0;
+void historyFree() {
+    for (int i = 0; i < history.capacity; i++) {
+        free(history.entries[i].name);
+    }
+    free(history.entries);
 }
+
+// ------------------ Dependencias ------------------
+
+// Un trabajo puede darse un nombre (id=) y esperar a otros anteriores del
+// fichero (after=). Como solo se puede citar lo ya cargado, el grafo no tiene
+// ciclos. Cada trabajo cuenta los padres que le faltan (waitingOn); al
+// recoger un padre se descuenta en sus hijos y los que llegan a cero pasan a
+// la política. Si un padre termina con código distinto de 0, ninguno de sus
+// descendientes se lanza.
+//
+// Con la CPU de cada trabajo se lleva además el camino crítico: la cadena
+// más cara del grafo, que acota por abajo el makespan por muchos slots que
+// haya. Los trabajos sin id= ni after= no tienen nodo y no cuestan nada.
+typedef enum {
+    DAG_PENDING,
+    DAG_DONE,
+    DAG_FAILED
+} DagState;
+
+typedef struct DagNode {
+    char *name;           // id=, NULL si no tiene
+    const char *exe;      // Nombre internado del ejecutable, para el informe
+    unsigned proc;        // Proceso en el pool mientras no termine (POOL_NONE luego)
+    DagState state;
+    int held;             // Admitido pero retenido a la espera de sus padres
+    unsigned *children;   // Nodos que esperan a este
+    int numChildren;
+    int childCapacity;
+    double startMs;       // CPU del camino más caro que llega hasta él
+    double finishMs;      // startMs más su propia CPU
+    int critParent;       // Padre por el que pasa ese camino (-1 = ninguno)
+} DagNode;
+
+typedef struct Dag {
+    DagNode *nodes;
+    int count;
+    int capacity;
+    int *index;           // Nombre -> nodo (-1 = libre), sondeo lineal
+    int indexCapacity;    // Siempre potencia de 2
+    int named;
+    int critical;         // Nodo en que acaba el camino crítico (-1 = ninguno)
+    int skipped;          // Trabajos no lanzados porque falló una dependencia
+} Dag;
+
+Dag dag = {NULL, 0, 0, NULL, 0, 0, -1, 0};
+
+// La clave son los len bytes de name, que no tiene por qué acabar en '\0'
+int* dagSlot(int *index, int capacity, const char *name, size_t len) {
+    unsigned mask = (unsigned)(capacity - 1);
+    unsigned i = stringHash(name, len) & mask;
+    while (index[i] >= 0) {
+        const char *n = dag.nodes[index[i]].name;
+        if (strncmp(n, name, len) == 0 && n[len] == '\0') {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &index[i];
+}
+
+void dagIndexGrow() {
+    int capacity = dag.indexCapacity ? dag.indexCapacity * 2 : 16;
+    int *index = (int*)malloc(capacity * sizeof(int));
+    if (!index) {
+        perror("Failed to allocate memory for dependencies");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < capacity; i++) {
+        index[i] = -1;
+    }
+    for (int i = 0; i < dag.indexCapacity; i++) {
+        if (dag.index[i] >= 0) {
+            const char *name = dag.nodes[dag.index[i]].name;
+            *dagSlot(index, capacity, name, strlen(name)) = dag.index[i];
+        }
+    }
+    free(dag.index);
+    dag.index = index;
+    dag.indexCapacity = capacity;
+}
+
+// Nodo de p, que se crea la primera vez que hace falta. Ojo: puede mover
+// dag.nodes, así que los punteros a otros nodos no sobreviven a la llamada.
+int dagNodeOf(Process *p) {
+    if (p->dagNode >= 0) {
+        return p->dagNode;
+    }
+    if (dag.count == dag.capacity) {
+        dag.capacity = dag.capacity ? dag.capacity * 2 : 64;
+        DagNode *nodes = (DagNode*)realloc(dag.nodes, dag.capacity * sizeof(DagNode));
+        if (!nodes) {
+            perror("Failed to allocate memory for dependencies");
+            exit(EXIT_FAILURE);
+        }
+        dag.nodes = nodes;
+    }
+    DagNode *n = &dag.nodes[dag.count];
+    memset(n, 0, sizeof(*n));
+    n->exe = p->executableName;
+    n->proc = p->id;
+    n->state = DAG_PENDING;
+    n->critParent = -1;
+    p->dagNode = dag.count++;
+    return p->dagNode;
+}
+
+// id=NAME. Si el nombre se repite, los after= posteriores citan al último
+void dagDeclare(Process *p, const char *name, size_t len) {
+    int node = dagNodeOf(p);
+    if (dag.nodes[node].name != NULL) {
+        fprintf(stderr, "Duplicate id= for %s ignored\n", p->executableName);
+        return;
+    }
+    if ((dag.named + 1) * 2 > dag.indexCapacity) {
+        dagIndexGrow();
+    }
+    dag.nodes[node].name = strndup(name, len);
+    if (!dag.nodes[node].name) {
+        perror("Failed to allocate memory for dependencies");
+        exit(EXIT_FAILURE);
+    }
+    int *slot = dagSlot(dag.index, dag.indexCapacity, name, len);
+    if (*slot < 0) {
+        dag.named++;
+    }
+    *slot = node;
+}
+
+// after=A,B,...: p espera a cada uno de los que aún no han terminado
+void dagAfter(Process *p, const char *s, const char *end) {
+    while (s < end) {
+        const char *comma = memchr(s, ',', (size_t)(end - s));
+        const char *nameEnd = comma ? comma : end;
+        size_t len = (size_t)(nameEnd - s);
+        int parent = dag.indexCapacity ? *dagSlot(dag.index, dag.indexCapacity, s, len) : -1;
+        int node = dagNodeOf(p);
+        if (parent < 0 || parent == node) {
+            fprintf(stderr, "Unknown dependency '%.*s' for %s\n", (int)len, s, p->executableName);
+        } else if (dag.nodes[parent].state == DAG_PENDING) {
+            DagNode *par = &dag.nodes[parent];
+            if (par->numChildren == par->childCapacity) {
+                par->childCapacity = par->childCapacity ? par->childCapacity * 2 : 4;
+                unsigned *children = (unsigned*)realloc(par->children,
+                                                        par->childCapacity * sizeof(unsigned));
+                if (!children) {
+                    perror("Failed to allocate memory for dependencies");
+                    exit(EXIT_FAILURE);
+                }
+                par->children = children;
+            }
+            par->children[par->numChildren++] = (unsigned)node;
+            p->waitingOn++;
+        } else {
+            // Ya terminó: solo cuenta para el camino crítico (o para no lanzarlo)
+            DagNode *n = &dag.nodes[node], *par = &dag.nodes[parent];
+            if (par->state == DAG_FAILED) {
+                n->state = DAG_FAILED;
+            }
+            if (par->finishMs > n->startMs) {
+                n->startMs = par->finishMs;
+                n->critParent = parent;
+            }
+        }
+        s = nameEnd + 1;
+    }
+}
+
+// Camino crítico frente al makespan real (o simulado)
+void dagReport(double makespan) {
+    if (dag.critical < 0) {
+        return;
+    }
+    int chain[64], length = 0, jobs = 0;
+    for (int n = dag.critical; n >= 0; n = dag.nodes[n].critParent) {
+        if (length < 64) {
+            chain[length++] = n;
+        }
+        jobs++;
+    }
+    char path[384];
+    size_t used = 0;
+    for (int i = length - 1; i >= 0 && used < sizeof(path); i--) {
+        DagNode *n = &dag.nodes[chain[i]];
+        used += snprintf(path + used, sizeof(path) - used, "%s%s", (i < length - 1) ? " -> " : "",
+                         n->name ? n->name : n->exe);
+    }
+    double criticalSec = dag.nodes[dag.critical].finishMs / 1000.0;
+    logMsg(LOG_INFO, "Critical path: %.3f s of CPU over %d jobs (%s%s)\n", criticalSec, jobs,
+           (jobs > length) ? "... -> " : "", path);
+    logMsg(LOG_INFO, "Makespan %.3f s, %.1f%% of it on the critical path\n", makespan,
+           makespan > 0 ? 100.0 * criticalSec / makespan : 0.0);
+    if (dag.skipped > 0) {
+        logMsg(LOG_INFO, "Skipped %d jobs whose dependencies failed\n", dag.skipped);
+    }
+}
+
+void dagFree() {
+    for (int i = 0; i < dag.count; i++) {
+        free(dag.nodes[i].name);
+        free(dag.nodes[i].children);
+    }
+    free(dag.nodes);
+    free(dag.index);
+}
+
+// ------------------ Carga de trabajos ------------------
+
+// Formato de una línea de trabajo (v2). Una línea que es solo una ruta
+// sigue valiendo; detrás pueden ir opciones y, tras "--", los argumentos:
+//
+//   ../work/work7 at=500 nice=5 expect=900 bursts=200,3000,200 -- -v 3
+//
+//  at=MS          llegada, en ms desde el arranque: se retiene hasta entonces
+//  nice=N         -20..19 (peso en FAIR)
+//  prio=N         0..139, menor = más urgente (por defecto 120 + nice)
+//  expect=MS      duración esperada; sustituye a la predicción del historial
+//  bursts=C,E,C   ráfagas alternas de CPU y E/S en ms (--simulate)
+//  id=NOMBRE      nombre para que otros trabajos dependan de este
+//  after=A,B      no se lanza hasta que terminen bien los trabajos A y B
+//  mem=MB         pico de memoria esperado (-M); si no, se aprende de wait4
+//  deadline=MS    plazo para terminar, contado desde la llegada (EDF)
+//
+// Las líneas vacías y las que empiezan por '#' se ignoran.
+#define DEFAULT_PRIORITY 120
+
+static inline int isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Avanza *s hasta el siguiente token y devuelve dónde acaba
+static inline const char* nextToken(const char **s, const char *end) {
+    const char *c = *s;
+    while (c < end && isBlank(*c)) {
+        c++;
+    }
+    *s = c;
+    while (c < end && !isBlank(*c)) {
+        c++;
+    }
+    return c;
+}
+
+// Entero con signo en [s, end); *stop queda en el primer carácter no usado
+static inline long parseLong(const char *s, const char *end, const char **stop) {
+    int neg = (s < end && *s == '-');
+    s += neg;
+    long v = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        v = v * 10 + (*s++ - '0');
+    }
+    *stop = s;
+    return neg ? -v : v;
+}
+
+// "a,b,c" -> ráfagas de p
+void parseBursts(Process *p, const char *s, const char *end) {
+    int n = 1;
+    for (const char *c = s; c < end; c++) {
+        n += (*c == ',');
+    }
+    free(p->bursts);
+    p->bursts = (int*)malloc(n * sizeof(int));
+    if (!p->bursts) {
+        perror("Failed to allocate memory for bursts");
+        exit(EXIT_FAILURE);
+    }
+    p->numBursts = 0;
+    while (p->numBursts < n) {
+        p->bursts[p->numBursts++] = (int)parseLong(s, end, &s);
+        if (s >= end || *s != ',') {
+            break;
+        }
+        s++;
+    }
+}
+
+// argv del trabajo: un único bloque con los punteros seguidos de las
+// cadenas. argv[0] es el nombre internado del ejecutable.
+void parseArgs(Process *p, const char *s, const char *end) {
+    int n = 0;
+    size_t bytes = 0;
+    for (const char *c = s, *tokEnd; (tokEnd = nextToken(&c, end)) > c; c = tokEnd) {
+        n++;
+        bytes += (size_t)(tokEnd - c) + 1;
+    }
+    if (n == 0) {
+        return;
+    }
+    p->argv = (char**)malloc((n + 2) * sizeof(char*) + bytes);
+    if (!p->argv) {
+        perror("Failed to allocate memory for arguments");
+        exit(EXIT_FAILURE);
+    }
+    char *out = (char*)(p->argv + n + 2);
+    p->argv[0] = (char*)p->executableName;
+    int i = 1;
+    for (const char *c = s, *tokEnd; (tokEnd = nextToken(&c, end)) > c; c = tokEnd) {
+        p->argv[i++] = out;
+        memcpy(out, c, tokEnd - c);
+        out += tokEnd - c;
+        *out++ = '\0';
+    }
+    p->argv[i] = NULL;
+}
+
+// Opciones tras la ruta, en una sola pasada y sin copiar la línea
+void parseJobOptions(Process *p, const char *s, const char *end) {
+    int priority = -1;
+    for (const char *tokEnd; (tokEnd = nextToken(&s, end)) > s; s = tokEnd) {
+        size_t len = (size_t)(tokEnd - s);
+        const char *eq = memchr(s, '=', len);
+        const char *val = eq ? eq + 1 : tokEnd;
+        const char *stop;
+        if (len == 2 && s[0] == '-' && s[1] == '-') {
+            parseArgs(p, tokEnd, end);
+            break;
+        } else if (eq == s + 2 && memcmp(s, "at", 2) == 0) {
+            p->arrivalMs = (int)parseLong(val, tokEnd, &stop);
+        } else if (eq == s + 4 && memcmp(s, "nice", 4) == 0) {
+            int nice = (int)parseLong(val, tokEnd, &stop);
+            p->nice = nice < -20 ? -20 : (nice > 19 ? 19 : nice);
+        } else if (eq == s + 4 && memcmp(s, "prio", 4) == 0) {
+            priority = (int)parseLong(val, tokEnd, &stop);
+            priority = priority < 0 ? 0 : (priority > 139 ? 139 : priority);
+        } else if (eq == s + 6 && memcmp(s, "expect", 6) == 0) {
+            p->predictedMs = (double)parseLong(val, tokEnd, &stop);
+        } else if (eq == s + 6 && memcmp(s, "bursts", 6) == 0) {
+            parseBursts(p, val, tokEnd);
+        } else if (eq == s + 2 && memcmp(s, "id", 2) == 0) {
+            dagDeclare(p, val, (size_t)(tokEnd - val));
+        } else if (eq == s + 5 && memcmp(s, "after", 5) == 0) {
+            dagAfter(p, val, tokEnd);
+        } else if (eq == s + 8 && memcmp(s, "deadline", 8) == 0) {
+            int ms = (int)parseLong(val, tokEnd, &stop);
+            p->deadlineMs = ms > 0 ? ms : 0;
+        } else if (eq == s + 3 && memcmp(s, "mem", 3) == 0) {
+            long mb = parseLong(val, tokEnd, &stop);
+            p->memKb = mb > 0 ? mb * 1024 : 0;
+        } else {
+            fprintf(stderr, "Unknown job option '%.*s' for %s\n", (int)len, s, p->executableName);
+        }
+    }
+    p->priority = (priority >= 0) ? priority : DEFAULT_PRIORITY + p->nice;
+}
+
+// Rellena p, recién sacado del pool, con una línea de trabajo de len bytes
+// (sin el salto de línea). entryTime es el momento real de llegada (al
+// cargar el fichero o al leerlo de la entrada continua); con at= se vuelve
+// a fijar cuando se admite.
+void initJob(Process *newProcess, const char *line, size_t len) {
+    const char *end = line + len;
+    const char *route = line;
+    const char *routeEnd = nextToken(&route, end);
+
+    // route contendrá algo como "./work/work7"
+    RouteEntry *e = internRoute(route, (size_t)(routeEnd - route));
+    newProcess->route = e->route;
+    newProcess->executableName = e->name;
+    newProcess->execFd = e->fd;
+
+    newProcess->pid = -1;
+    gettimeofday(&newProcess->entryTime, NULL);
+    newProcess->remainingTime = 0; // Por defecto
+    newProcess->pidfd = -1;
+    newProcess->slot = -1;
+    newProcess->cpuUserUs = 0;
+    newProcess->cpuSysUs = 0;
+    newProcess->maxRssKb = 0;
+    newProcess->arrivalSec = nowSeconds();
+    newProcess->readySec = newProcess->arrivalSec;
+    newProcess->firstRunSec = -1;
+    newProcess->waitSec = 0;
+    newProcess->preemptions = 0;
+    newProcess->level = 0;
+    newProcess->levelSec = -1;
+    newProcess->predictedMs = predictRuntime(newProcess->executableName);
+    newProcess->ranMs = 0;
+    newProcess->quantumMs = 0;
+    newProcess->nice = 0;
+    newProcess->vruntime = 0;
+    newProcess->cpuNs = 0;
+    newProcess->arrivalMs = 0;
+    newProcess->bursts = NULL;
+    newProcess->numBursts = 0;
+    newProcess->burst = 0;
+    newProcess->burstLeftMs = 0;
+    newProcess->simCpuMs = 0;
+    newProcess->argv = NULL;
+    newProcess->deadlineMs = 0;
+    newProcess->deadlineSec = INFINITY;
+    newProcess->dagNode = -1;
+    newProcess->waitingOn = 0;
+    newProcess->memKb = 0;
+    newProcess->reservedKb = 0;
+    newProcess->statmFd = -1;
+    newProcess->jobNo = jobsSeen++;
+    jobIndexInsert(newProcess->jobNo, newProcess->id);
+    newProcess->cgroupFd = -1;
+    newProcess->outFds[0] = newProcess->outFds[1] = -1;
+    newProcess->logFds[0] = newProcess->logFds[1] = -1;
+    newProcess->captured = NULL;
+    newProcess->capturedLen = 0;
+    parseJobOptions(newProcess, routeEnd, end);
+    setStatus(newProcess, NEW);
+}
+
+// ¿Hay algo que cargar en esta línea?
+static inline int isJobLine(const char *line, size_t len) {
+    const char *s = line;
+    return nextToken(&s, line + len) > s && *s != '#';
+}
+
+// Crea un proceso NEW para la línea dada y lo encola
+void enqueueJob(Queue *q, const char *line, size_t len) {
+    if (!isJobLine(line, len)) {
+        return;
+    }
+    Process *newProcess = allocProcess();
+    initJob(newProcess, line, len);
+    enqueue(q, newProcess);
+    logMsg(LOG_DEBUG, "Enqueued process: %s\n", newProcess->executableName);
+}
+
+// Lector de líneas de trabajo. Un fichero normal se mapea entero con mmap y
+// las líneas se recorren con memchr sin copiarlas; stdin o un FIFO se leen
+// con getline. En ambos casos no hay límite de longitud de línea.
+typedef struct JobReader {
+    FILE *file;  // Solo si no se pudo mapear
+    char *map;
+    size_t size;
+    size_t pos;
+    char *line;  // Buffer de getline
+    size_t lineCap;
+} JobReader;
+
+// Devuelve 0 si no se pudo abrir
+int openJobReader(JobReader *r, const char *filename) {
+    memset(r, 0, sizeof(*r));
+    if (strcmp(filename, "-") == 0) {
+        r->file = stdin;
+        return 1;
+    }
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            close(fd);
+            r->map = (char*)map;
+            r->size = st.st_size;
+            return 1;
+        }
+    }
+    r->file = fdopen(fd, "r");
+    if (!r->file) {
+        close(fd);
+        return 0;
+    }
+    return 1;
+}
+
+// Siguiente línea (sin el salto); devuelve 0 al final
+int nextJobLine(JobReader *r, const char **line, size_t *len) {
+    if (r->map != NULL) {
+        if (r->pos >= r->size) {
+            return 0;
+        }
+        const char *start = r->map + r->pos;
+        const char *nl = memchr(start, '\n', r->size - r->pos);
+        *len = nl ? (size_t)(nl - start) : r->size - r->pos;
+        *line = start;
+        r->pos += *len + 1;
+        return 1;
+    }
+    if (r->file == NULL) {
+        return 0;
+    }
+    ssize_t n = getline(&r->line, &r->lineCap, r->file);
+    if (n < 0) {
+        return 0;
+    }
+    if (n > 0 && r->line[n - 1] == '\n') {
+        n--;
+    }
+    *line = r->line;
+    *len = (size_t)n;
+    return 1;
+}
+
+void closeJobReader(JobReader *r) {
+    if (r->map != NULL) {
+        munmap(r->map, r->size);
+    }
+    if (r->file != NULL && r->file != stdin) {
+        fclose(r->file);
+    }
+    free(r->line);
+    memset(r, 0, sizeof(*r));
+}
+
+// Carga procesos desde un archivo
+void loadProcessesFromFile(const char *filename, Queue *q) {
+    JobReader reader;
+    if (!openJobReader(&reader, filename)) {
+        perror("Failed to open file");
+        exit(EXIT_FAILURE);
+    }
+
+    const char *line;
+    size_t len;
+    while (nextJobLine(&reader, &line, &len)) {
+        enqueueJob(q, line, len);
+    }
+
+    closeJobReader(&reader);
+}
+
+// Copia lo que nos interesa del rusage de wait4
+void recordUsage(Process *p, struct rusage *ru) {
+    p->cpuUserUs = ru->ru_utime.tv_sec * 1000000L + ru->ru_utime.tv_usec;
+    p->cpuSysUs = ru->ru_stime.tv_sec * 1000000L + ru->ru_stime.tv_usec;
+    p->maxRssKb = ru->ru_maxrss;
+}
+
+// Informe común a FCFS y RR cuando un proceso termina
+void printProcessReport(Process *p, int code) {
+    struct timeval finishTime;
+    gettimeofday(&finishTime, NULL);
+    double totalTime = timeval_diff(&p->entryTime, &finishTime);
+
+    logMsg(LOG_INFO,
+           "-----------------------------------------------------\n"
+           "Process %d finished with code: %d\n"
+           "Executable: %s\n"
+           "Route: %s\n"
+           "Time to execute: %.6f\n"
+           "-----------------------------------------------------\n",
+           p->pid, code, p->executableName, p->route, totalTime);
+}
+
+// ------------------ Métricas ------------------
+
+// Al terminar cada trabajo guardamos un registro (el Process se reutiliza);
+// al final se vuelcan todos en CSV o JSON con medias y percentiles.
+typedef struct JobMetrics {
+    int pid;
+    const char *executableName; // Cadena internada: vive hasta el final
+    int exitCode;
+    double arrival;             // Segundos desde el arranque del planificador
+    double turnaround;          // Llegada -> fin
+    double response;            // Llegada -> primer despacho
+    double waiting;             // Tiempo listo en cola sin ejecutarse
+    int preemptions;
+    double cpuUser;             // Segundos, según wait4
+    double cpuSys;
+    long maxRssKb;
+    int quantumMs;              // Quantum con el que corrió por última vez
+    char *output;               // Salida capturada con -C (NULL si no hay)
+    size_t outputLen;
+} JobMetrics;
+
+JobMetrics *metrics = NULL;
+int numMetrics = 0;
+int metricsCapacity = 0;
+double startSec = 0;        // nowSeconds() al arrancar
+char *metricsPath = NULL;   // Fichero de salida (-m), NULL = no se guardan
+
+// Sumas al vuelo de todos los terminados, con o sin -m: lo que consulta el
+// socket de control sin recorrer los registros
+typedef struct RunTotals {
+    long finished;
+    long failed;       // Código distinto de 0
+    double turnaround; // Sumas en segundos
+    double response;
+    double waiting;
+    long preemptions;
+} RunTotals;
+
+RunTotals totals = {0, 0, 0, 0, 0, 0};
+
+void recordMetrics(Process *p, int code) {
+    double now = nowSeconds();
+    totals.finished++;
+    totals.failed += (code != 0);
+    totals.turnaround += now - p->arrivalSec;
+    totals.response += (p->firstRunSec >= 0) ? p->firstRunSec - p->arrivalSec : 0;
+    totals.waiting += p->waitSec;
+    totals.preemptions += p->preemptions;
+    if (metricsPath == NULL) {
+        return;
+    }
+    if (numMetrics == metricsCapacity) {
+        metricsCapacity = metricsCapacity ? metricsCapacity * 2 : 256;
+        JobMetrics *m = (JobMetrics*)realloc(metrics, metricsCapacity * sizeof(JobMetrics));
+        if (!m) {
+            perror("Failed to allocate memory for metrics");
+            exit(EXIT_FAILURE);
+        }
+        metrics = m;
+    }
+    JobMetrics *m = &metrics[numMetrics++];
+    m->pid = p->pid;
+    m->executableName = p->executableName;
+    m->exitCode = code;
+    m->arrival = p->arrivalSec - startSec;
+    m->turnaround = now - p->arrivalSec;
+    m->response = (p->firstRunSec >= 0) ? p->firstRunSec - p->arrivalSec : 0;
+    m->waiting = p->waitSec;
+    m->preemptions = p->preemptions;
+    m->cpuUser = p->cpuUserUs / 1e6;
+    m->cpuSys = p->cpuSysUs / 1e6;
+    m->maxRssKb = p->maxRssKb;
+    m->quantumMs = p->quantumMs;
+    m->output = p->captured; // El registro se queda con el buffer
+    m->outputLen = p->capturedLen;
+    p->captured = NULL;
+}
+
+// Quantum vigente a lo largo de la ejecución (RR auto): un cambio por
+// reajuste, con el instante en segundos desde el arranque
+typedef struct QuantumChange {
+    double t;
+    int quantumMs;
+} QuantumChange;
+
+QuantumChange *quantumHistory = NULL;
+int numQuantumChanges = 0;
+int quantumHistoryCapacity = 0;
+
+void recordQuantum(double t, int quantumMs) {
+    if (numQuantumChanges == quantumHistoryCapacity) {
+        quantumHistoryCapacity = quantumHistoryCapacity ? quantumHistoryCapacity * 2 : 64;
+        QuantumChange *h = (QuantumChange*)realloc(quantumHistory,
+                                                   quantumHistoryCapacity * sizeof(QuantumChange));
+        if (!h) {
+            perror("Failed to allocate memory for quantum history");
+            exit(EXIT_FAILURE);
+        }
+        quantumHistory = h;
+    }
+    quantumHistory[numQuantumChanges].t = t;
+    quantumHistory[numQuantumChanges].quantumMs = quantumMs;
+    numQuantumChanges++;
+}
+
+int compareDoubles(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Media y percentiles (rango más cercano) de un campo de los registros
+typedef struct Summary {
+    double mean, p50, p95, p99;
+} Summary;
+
+double percentile(double *sorted, int n, double q) {
+    int rank = (int)ceil(q * n);
+    return sorted[(rank > 0 ? rank : 1) - 1];
+}
+
+Summary summarize(size_t offset) {
+    Summary s = {0, 0, 0, 0};
+    if (numMetrics == 0) {
+        return s;
+    }
+    double *values = (double*)malloc(numMetrics * sizeof(double));
+    if (!values) {
+        perror("Failed to allocate memory for metrics");
+        exit(EXIT_FAILURE);
+    }
+    double total = 0;
+    for (int i = 0; i < numMetrics; i++) {
+        values[i] = *(double*)((char*)&metrics[i] + offset);
+        total += values[i];
+    }
+    qsort(values, numMetrics, sizeof(double), compareDoubles);
+    s.mean = total / numMetrics;
+    s.p50 = percentile(values, numMetrics, 0.50);
+    s.p95 = percentile(values, numMetrics, 0.95);
+    s.p99 = percentile(values, numMetrics, 0.99);
+    free(values);
+    return s;
+}
+
+// Campos con resumen, en el orden en que se escriben
+typedef struct MetricField {
+    const char *name;
+    size_t offset;
+} MetricField;
+
+MetricField summaryFields[] = {
+    {"turnaround", offsetof(JobMetrics, turnaround)},
+    {"response", offsetof(JobMetrics, response)},
+    {"waiting", offsetof(JobMetrics, waiting)},
+    {"cpu_user", offsetof(JobMetrics, cpuUser)},
+    {"cpu_sys", offsetof(JobMetrics, cpuSys)},
+};
+#define NUM_SUMMARY_FIELDS (int)(sizeof(summaryFields) / sizeof(summaryFields[0]))
+
+// CSV: una fila por trabajo y luego una fila por estadístico (mean, p50,
+// p95, p99) con los campos que tienen resumen
+void writeMetricsCsv(FILE *f) {
+    fprintf(f, "row,pid,executable,exit_code,arrival,turnaround,response,waiting,preemptions,cpu_user,cpu_sys,max_rss_kb,quantum_ms\n");
+    for (int i = 0; i < numMetrics; i++) {
+        JobMetrics *m = &metrics[i];
+        fprintf(f, "job,%d,", m->pid);
+        writeCsvString(f, m->executableName);
+        fprintf(f, ",%d,%.6f,%.6f,%.6f,%.6f,%d,%.6f,%.6f,%ld,%d\n",
+                m->exitCode, m->arrival, m->turnaround,
+                m->response, m->waiting, m->preemptions, m->cpuUser, m->cpuSys, m->maxRssKb,
+                m->quantumMs);
+    }
+    Summary s[NUM_SUMMARY_FIELDS];
+    for (int k = 0; k < NUM_SUMMARY_FIELDS; k++) {
+        s[k] = summarize(summaryFields[k].offset);
+    }
+    const char *names[] = {"mean", "p50", "p95", "p99"};
+    for (int r = 0; r < 4; r++) {
+        double v[NUM_SUMMARY_FIELDS];
+        for (int k = 0; k < NUM_SUMMARY_FIELDS; k++) {
+            v[k] = (r == 0) ? s[k].mean : (r == 1) ? s[k].p50 : (r == 2) ? s[k].p95 : s[k].p99;
+        }
+        fprintf(f, "%s,,,,,%.6f,%.6f,%.6f,,%.6f,%.6f,,\n", names[r], v[0], v[1], v[2], v[3], v[4]);
+    }
+}
+
+void writeMetricsJson(FILE *f, const char *policy, int quantum) {
+    fprintf(f, "{\n  \"policy\": \"%s\",\n  \"quantum_ms\": %d,\n  \"slots\": %d,\n", policy, quantum, numSlots);
+    fprintf(f, "  \"jobs\": [\n");
+    for (int i = 0; i < numMetrics; i++) {
+        JobMetrics *m = &metrics[i];
+        fprintf(f, "    {\"pid\": %d, \"executable\": ", m->pid);
+        writeJsonString(f, m->executableName, strlen(m->executableName));
+        fprintf(f, ", \"exit_code\": %d, "
+                   "\"arrival\": %.6f, \"turnaround\": %.6f, \"response\": %.6f, "
+                   "\"waiting\": %.6f, \"preemptions\": %d, \"cpu_user\": %.6f, "
+                   "\"cpu_sys\": %.6f, \"max_rss_kb\": %ld, \"quantum_ms\": %d",
+                m->exitCode, m->arrival, m->turnaround,
+                m->response, m->waiting, m->preemptions, m->cpuUser, m->cpuSys,
+                m->maxRssKb, m->quantumMs);
+        if (m->output != NULL) {
+            fprintf(f, ", \"output\": ");
+            writeJsonString(f, m->output, m->outputLen);
+        }
+        fprintf(f, "}%s\n", (i + 1 < numMetrics) ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+    if (numQuantumChanges > 0) {
+        fprintf(f, "  \"quanta\": [");
+        for (int i = 0; i < numQuantumChanges; i++) {
+            fprintf(f, "%s{\"t\": %.6f, \"quantum_ms\": %d}", i ? ", " : "",
+                    quantumHistory[i].t, quantumHistory[i].quantumMs);
+        }
+        fprintf(f, "],\n");
+    }
+    fprintf(f, "  \"summary\": {\n");
+    for (int k = 0; k < NUM_SUMMARY_FIELDS; k++) {
+        Summary s = summarize(summaryFields[k].offset);
+        fprintf(f, "    \"%s\": {\"mean\": %.6f, \"p50\": %.6f, \"p95\": %.6f, \"p99\": %.6f}%s\n",
+                summaryFields[k].name, s.mean, s.p50, s.p95, s.p99,
+                (k + 1 < NUM_SUMMARY_FIELDS) ? "," : "");
+    }
+    fprintf(f, "  }\n}\n");
+}
+
+// El formato se elige por la extensión: .json o, si no, CSV
+void writeMetrics(const char *policy, int quantum) {
+    if (metricsPath == NULL) {
+        return;
+    }
+    FILE *f = fopen(metricsPath, "w");
+    if (!f) {
+        perror("Failed to open metrics file");
+        return;
+    }
+    size_t len = strlen(metricsPath);
+    if (len >= 5 && strcmp(metricsPath + len - 5, ".json") == 0) {
+        writeMetricsJson(f, policy, quantum);
+    } else {
+        writeMetricsCsv(f);
+    }
+    fclose(f);
+    logMsg(LOG_INFO, "Metrics for %d jobs written to %s\n", numMetrics, metricsPath);
+}
+
+// ------------------ Slots y afinidad ------------------
+
+// Crea n slots. Si pin != 0, cada slot se fija a una CPU distinta de las
+// que tiene permitidas el planificador (repartidas en orden, cíclicamente)
+void initSlots(int n, int pin) {
+    slots = (Slot*)calloc(n, sizeof(Slot));
+    if (!slots) {
+        perror("Failed to allocate memory for slots");
+        exit(EXIT_FAILURE);
+    }
+    numSlots = n;
+
+    int cpus[CPU_SETSIZE];
+    int ncpus = 0;
+    if (pin) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+            perror("sched_getaffinity failed");
+            pin = 0;
+        } else {
+            for (int c = 0; c < CPU_SETSIZE; c++) {
+                if (CPU_ISSET(c, &allowed)) {
+                    cpus[ncpus++] = c;
+                }
+            }
+        }
+        if (pin && n > ncpus) {
+            logMsg(LOG_ERROR, "Warning: %d slots but only %d CPUs available, some slots share a CPU\n", n, ncpus);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        slots[i].cpu = (pin && ncpus > 0) ? cpus[i % ncpus] : -1;
+        slots[i].proc = NULL;
+    }
+}
+
+// Fija pid (0 = el propio proceso) a una única CPU. Devuelve -1 si falla;
+// no escribe nada porque también se llama desde el hijo de clone, que
+// comparte memoria (y el stdio) con el padre
+int pinToCpu(pid_t pid, int cpu) {
+    if (cpu < 0) {
+        return 0;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(pid, sizeof(set), &set);
+}
+
+int runningCount() {
+    int n = 0;
+    for (int i = 0; i < numSlots; i++) {
+        if (slots[i].proc != NULL) {
+            n++;
+        }
+    }
+    return n;
+}
+
+// ------------------ Lanzamiento de procesos ------------------
+
+// Tiempo que el planificador pasa bloqueado en cada lanzamiento: con fork
+// hasta que vuelve fork(), con spawn hasta que el hijo ya ha hecho el exec
+typedef struct LaunchStats {
+    long count;
+    long long totalNs;
+    long long maxNs;
+} LaunchStats;
+
+LaunchStats launchStats = {0, 0, 0};
+
+#define SPAWN_STACK_SIZE (64 * 1024)
+
+// Argumentos del hijo de clone. Como comparte memoria con el padre, err le
+// llega directamente si el exec falla.
+typedef struct SpawnArgs {
+    int execFd;
+    const char *route; // Si no hay fd (la ruta no se pudo abrir) o es un script
+    char **argv;
+    int cpu;
+    sigset_t mask; // Máscara que tenía el padre antes de bloquear todo
+    int err;
+} SpawnArgs;
+
+char *spawnStack = NULL;
+
+// Extremos de escritura de las tuberías de salida del trabajo que se está
+// lanzando (ver prepareOutput); el hijo los pone como 1 y 2. -1 = heredar.
+int childStdio[2] = {-1, -1};
+
+// cgroup.procs de la hoja del trabajo que se está lanzando (-P cgroup). El
+// hijo se mete en ella antes del exec, así que todo lo que cree queda dentro.
+int childCgroupFd = -1;
+
+void enterChildCgroup() {
+    if (childCgroupFd >= 0) {
+        // Si falla, lo intenta el padre en cgroupLaunched
+        ssize_t r = write(childCgroupFd, "0", 1);
+        (void)r;
+    }
+}
+
+void redirectChildStdio() {
+    for (int k = 0; k < 2; k++) {
+        if (childStdio[k] >= 0) {
+            dup2(childStdio[k], STDOUT_FILENO + k);
+        }
+    }
+}
+
+int spawnChild(void *arg) {
+    SpawnArgs *a = (SpawnArgs*)arg;
+
+    // Sin CLONE_SIGHAND la tabla de handlers es propia: restaurarlos aquí no
+    // afecta al padre, y evita que un handler corra sobre su memoria
+    struct sigaction dfl;
+    memset(&dfl, 0, sizeof(dfl));
+    dfl.sa_handler = SIG_DFL;
+    sigaction(SIGCHLD, &dfl, NULL);
+    sigprocmask(SIG_SETMASK, &a->mask, NULL);
+
+    pinToCpu(0, a->cpu);
+    enterChildCgroup();
+    redirectChildStdio();
+    // fexecve de un script "#!" da ENOENT: el intérprete no puede abrir el
+    // fd, que se cierra en el exec. Entonces, o si la ruta no se pudo abrir
+    // (p.ej. "echo", que se busca en el PATH), se hace lo mismo que fork
+    if (a->execFd < 0 || (fexecve(a->execFd, a->argv, environ) == -1 && errno == ENOENT)) {
+        execvp(a->route, a->argv);
+    }
+    a->err = errno;
+    _exit(EXIT_FAILURE);
+}
+
+pid_t spawnProcess(Process *p, int cpu) {
+    if (spawnStack == NULL) {
+        // El padre está parado mientras el hijo usa la pila, así que basta
+        // una para todos los lanzamientos
+        spawnStack = (char*)malloc(SPAWN_STACK_SIZE);
+        if (!spawnStack) {
+            perror("Failed to allocate memory for spawn stack");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    SpawnArgs args;
+    args.execFd = p->execFd;
+    args.route = p->route;
+    char *nameOnly[2] = {(char*)p->executableName, NULL};
+    args.argv = p->argv ? p->argv : nameOnly;
+    args.cpu = cpu;
+    args.err = 0;
+
+    // Ninguna señal debe llegar al hijo mientras comparte nuestra memoria
+    sigset_t all;
+    sigfillset(&all);
+    sigprocmask(SIG_BLOCK, &all, &args.mask);
+    pid_t pid = clone(spawnChild, spawnStack + SPAWN_STACK_SIZE,
+                      CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+    int cloneErr = errno;
+    sigprocmask(SIG_SETMASK, &args.mask, NULL);
+
+    if (pid < 0) {
+        errno = cloneErr;
+        perror("clone failed");
+        return -1;
+    }
+    if (args.err != 0) {
+        // El hijo ya salió con EXIT_FAILURE; se recoge como cualquier otro
+        errno = args.err;
+        perror("Execution failed");
+    }
+    return pid;
+}
+
+pid_t forkProcess(Process *p, int cpu) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork failed");
+        return -1;
+    } else if (pid == 0) {
+        // Hijo: se fija a la CPU del slot antes de ejecutar
+        if (pinToCpu(0, cpu) == -1) {
+            perror("sched_setaffinity failed");
+        }
+        enterChildCgroup();
+        redirectChildStdio();
+        char *nameOnly[2] = {(char*)p->executableName, NULL};
+        execvp(p->route, p->argv ? p->argv : nameOnly);
+        perror("Execution failed");
+        _exit(EXIT_FAILURE); // Sin atexit: el anillo de registro es del padre
+    }
+    return pid;
+}
+
+// Lanza p con el backend elegido y apunta cuánto ha tardado
+pid_t launchProcess(Process *p, int cpu) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = (launchBackend == LAUNCH_SPAWN) ? spawnProcess(p, cpu) : forkProcess(p, cpu);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (pid > 0) {
+        long long ns = (long long)(end.tv_sec - start.tv_sec) * 1000000000LL +
+                       (end.tv_nsec - start.tv_nsec);
+        launchStats.count++;
+        launchStats.totalNs += ns;
+        if (ns > launchStats.maxNs) {
+            launchStats.maxNs = ns;
+        }
+    }
+    return pid;
+}
+
+void printLaunchStats() {
+    if (launchStats.count == 0) {
+        return;
+    }
+    logMsg(LOG_INFO, "Launch backend: %s, %ld launches, mean %.1f us, max %.1f us\n",
+           launchBackend == LAUNCH_SPAWN ? "spawn" : "fork",
+           launchStats.count,
+           launchStats.totalNs / 1000.0 / launchStats.count,
+           launchStats.maxNs / 1000.0);
+}
+
+// ------------------ Tabla de finalización ------------------
+
+// Tabla hash PID -> Process (direccionamiento abierto, sondeo lineal) con los
+// hijos lanzados que aún no se han recogido. Solo se llama a wait4 sobre PIDs
+// que están en la tabla y se quitan al recogerlos, así que un mismo hijo no
+// se recoge dos veces aunque lleguen varios avisos de su salida.
+typedef struct CompletionTable {
+    pid_t *pids;       // 0 = hueco libre
+    Process **procs;
+    int capacity;      // Siempre potencia de 2
+    int count;
+} CompletionTable;
+
+CompletionTable completions = {NULL, NULL, 0, 0};
+
+unsigned pidHash(pid_t pid, int capacity) {
+    return ((unsigned)pid * 2654435761u) & (unsigned)(capacity - 1);
+}
+
+void tableInit(int capacity) {
+    completions.pids = (pid_t*)calloc(capacity, sizeof(pid_t));
+    completions.procs = (Process**)calloc(capacity, sizeof(Process*));
+    if (!completions.pids || !completions.procs) {
+        perror("Failed to allocate memory for completion table");
+        exit(EXIT_FAILURE);
+    }
+    completions.capacity = capacity;
+    completions.count = 0;
+}
+
+void tableInsert(pid_t pid, Process *p) {
+    // Crecemos al 50% de ocupación para que los sondeos sean cortos
+    if ((completions.count + 1) * 2 > completions.capacity) {
+        CompletionTable old = completions;
+        tableInit(old.capacity * 2);
+        for (int i = 0; i < old.capacity; i++) {
+            if (old.pids[i] != 0) {
+                tableInsert(old.pids[i], old.procs[i]);
+            }
+        }
+        free(old.pids);
+        free(old.procs);
+    }
+    unsigned mask = (unsigned)(completions.capacity - 1);
+    unsigned i = pidHash(pid, completions.capacity);
+    while (completions.pids[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    completions.pids[i] = pid;
+    completions.procs[i] = p;
+    completions.count++;
+}
+
+Process* tableLookup(pid_t pid) {
+    unsigned mask = (unsigned)(completions.capacity - 1);
+    unsigned i = pidHash(pid, completions.capacity);
+    while (completions.pids[i] != 0) {
+        if (completions.pids[i] == pid) {
+            return completions.procs[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+void tableRemove(pid_t pid) {
+    unsigned mask = (unsigned)(completions.capacity - 1);
+    unsigned i = pidHash(pid, completions.capacity);
+    while (completions.pids[i] != pid) {
+        if (completions.pids[i] == 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    // Borrado con desplazamiento hacia atrás: recolocamos las entradas
+    // siguientes del mismo grupo para no dejar huecos en sus sondeos
+    unsigned j = i;
+    while (1) {
+        completions.pids[i] = 0;
+        completions.procs[i] = NULL;
+        while (1) {
+            j = (j + 1) & mask;
+            if (completions.pids[j] == 0) {
+                completions.count--;
+                return;
+            }
+            unsigned k = pidHash(completions.pids[j], completions.capacity);
+            // La entrada j puede ocupar el hueco i si su posición ideal k no
+            // está en el tramo circular (i, j]
+            if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+                break;
+            }
+        }
+        completions.pids[i] = completions.pids[j];
+        completions.procs[i] = completions.procs[j];
+        i = j;
+    }
+}
+
+// ------------------ Avisos de SIGCHLD ------------------
+
+// El handler solo apunta el PID en un anillo sin bloqueos y despierta al
+// bucle principal escribiendo en un eventfd; todo lo demás (wait4, informes,
+// liberar memoria) se hace fuera del contexto de señal.
+#define CHILD_RING_SIZE 1024 // Potencia de 2
+
+typedef struct ChildRecord {
+    pid_t pid;
+    int code; // si_code: CLD_EXITED, CLD_KILLED, CLD_DUMPED
+} ChildRecord;
+
+ChildRecord childRing[CHILD_RING_SIZE];
+_Atomic unsigned childRingHead = 0; // Solo lo avanza el handler
+_Atomic unsigned childRingTail = 0; // Solo lo avanza el bucle principal
+int sigEventFd = -1;
+
+void sigchld_handler(int signo, siginfo_t *info, void *context) {
+    (void)signo;
+    (void)context;
+    int savedErrno = errno;
+
+    unsigned head = atomic_load_explicit(&childRingHead, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&childRingTail, memory_order_acquire);
+    if (head - tail < CHILD_RING_SIZE) {
+        childRing[head & (CHILD_RING_SIZE - 1)].pid = info->si_pid;
+        childRing[head & (CHILD_RING_SIZE - 1)].code = info->si_code;
+        atomic_store_explicit(&childRingHead, head + 1, memory_order_release);
+    }
+    // Con el anillo lleno no se pierde la salida: el barrido de
+    // drainChildRing la recoge igualmente
+
+    uint64_t one = 1;
+    ssize_t r = write(sigEventFd, &one, sizeof(one));
+    (void)r;
+    errno = savedErrno;
+}
+
+void installSigchldHandler() {
+    sigEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sigEventFd == -1) {
+        perror("eventfd failed");
+        exit(EXIT_FAILURE);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = sigchld_handler;
+    sigemptyset(&sa.sa_mask);
+    // Las paradas por SIGSTOP las provocamos nosotros: no hace falta aviso
+    sa.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+    if (sigaction(SIGCHLD, &sa, NULL) == -1) {
+        perror("Error setting SIGCHLD handler");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// ------------------ Bucle de eventos ------------------
+
+// Tipos de descriptor registrados en epoll. En data.u64 guardamos el tipo en
+// los 32 bits altos y el índice (slot o PID) en los bajos. Las salidas llegan
+// por dos vías (pidfd y SIGCHLD); ambas pasan por la tabla de finalización.
+#define EV_TIMER 1 // timerfd de un slot: fin de quantum
+#define EV_CHILD 2 // pidfd de un hijo: el proceso ha terminado
+#define EV_SIGNAL 3 // eventfd del handler de SIGCHLD
+#define EV_INTAKE 4 // Fuente de trabajos continua (stdin, FIFO, conexión)
+#define EV_LISTEN 5 // Socket de escucha de trabajos
+#define EV_PERIODIC 6 // timerfd periódico de la política (p.ej. boost de MLFQ)
+#define EV_ARRIVAL 7 // timerfd de la próxima llegada diferida (at=)
+
+#define MAX_EVENTS 64
+
+int epollFd = -1;
+int periodicFd = -1;
+int arrivalFd = -1;
+
+int pidfdOpen(pid_t pid) {
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+}
+
+void watchFd(int fd, int type, int id) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = ((uint64_t)type << 32) | (uint32_t)id;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        perror("epoll_ctl failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void unwatchFd(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+// Programa el timer del slot para dentro de ms milisegundos (0 = desarmar).
+// timerfd_settime también descarta expiraciones pendientes de leer.
+void armTimer(Slot *s, int ms) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+    timerfd_settime(s->timerFd, 0, &its, NULL);
+}
+
+// Crea el conjunto epoll y un timerfd por slot
+void initEventLoop() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        perror("epoll_create1 failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < numSlots; i++) {
+        slots[i].timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (slots[i].timerFd == -1) {
+            perror("timerfd_create failed");
+            exit(EXIT_FAILURE);
+        }
+        watchFd(slots[i].timerFd, EV_TIMER, i);
+    }
+    watchFd(sigEventFd, EV_SIGNAL, 0);
+
+    periodicFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (periodicFd == -1) {
+        perror("timerfd_create failed");
+        exit(EXIT_FAILURE);
+    }
+    watchFd(periodicFd, EV_PERIODIC, 0);
+
+    arrivalFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (arrivalFd == -1) {
+        perror("timerfd_create failed");
+        exit(EXIT_FAILURE);
+    }
+    watchFd(arrivalFd, EV_ARRIVAL, 0);
+}
+
+// Arma el timer periódico de la política cada ms milisegundos (0 = parar)
+void startPeriodicTimer(int ms) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+    its.it_interval = its.it_value;
+    timerfd_settime(periodicFd, 0, &its, NULL);
+}
+
+void closeEventLoop() {
+    for (int i = 0; i < numSlots; i++) {
+        close(slots[i].timerFd);
+    }
+    close(periodicFd);
+    close(arrivalFd);
+    close(epollFd);
+}
+
+// ------------------ Salida de los hijos ------------------
+
+// Con -o DIR la salida estándar y la de errores de cada trabajo van por dos
+// tuberías a DIR/<n>-<nombre>.out y .err, y el bucle de eventos las vacía
+// con splice, sin copiarlas a memoria del planificador. Con -C BYTES además
+// se guardan los primeros BYTES de stdout en su registro de métricas (solo
+// en JSON): mientras queda hueco se lee y se escribe, y luego vuelve a
+// splice. Sin -o lo que no se captura va a /dev/null.
+#define EV_STDOUT 8 // Tubería de stdout de un trabajo (id = índice en el pool)
+#define EV_STDERR 9 // Tubería de stderr de un trabajo
+
+const char *outputDir = NULL;
+size_t captureLimit = 0;
+int devNullFd = -1;
+
+int capturingOutput() {
+    return outputDir != NULL || captureLimit > 0;
+}
+
+void initOutput() {
+    if (outputDir != NULL && mkdir(outputDir, 0755) == -1 && errno != EEXIST) {
+        perror("Failed to create output directory");
+        exit(EXIT_FAILURE);
+    }
+    devNullFd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (devNullFd == -1) {
+        perror("Failed to open /dev/null");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Crea las tuberías (y los ficheros) de p justo antes de lanzarlo
+void prepareOutput(Process *p) {
+    for (int k = 0; k < 2; k++) {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) == -1) {
+            perror("pipe2 failed");
+            exit(EXIT_FAILURE);
+        }
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        p->outFds[k] = fds[0];
+        childStdio[k] = fds[1];
+        if (outputDir != NULL) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/%u-%s.%s", outputDir, p->jobNo,
+                     p->executableName, k ? "err" : "out");
+            p->logFds[k] = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (p->logFds[k] == -1) {
+                perror("Failed to open job log");
+            }
+        }
+    }
+}
+
+void closeOutput(Process *p, int k) {
+    if (p->outFds[k] >= 0) {
+        unwatchFd(p->outFds[k]);
+        close(p->outFds[k]);
+        p->outFds[k] = -1;
+    }
+    if (p->logFds[k] >= 0) {
+        close(p->logFds[k]);
+        p->logFds[k] = -1;
+    }
+}
+
+// Ya lanzado (o fallido): cerramos nuestra copia de los extremos de
+// escritura, para ver el fin de fichero cuando el hijo termine
+void outputLaunched(Process *p, pid_t pid) {
+    for (int k = 0; k < 2; k++) {
+        close(childStdio[k]);
+        childStdio[k] = -1;
+        if (pid > 0) {
+            watchFd(p->outFds[k], EV_STDOUT + k, (int)p->id);
+        } else {
+            closeOutput(p, k);
+        }
+    }
+}
+
+// Pasa a su destino lo que haya en la tubería k de p, hasta vaciarla. Al
+// llegar al fin de fichero la cierra.
+void drainOutput(Process *p, int k) {
+    int in = p->outFds[k];
+    if (in < 0) {
+        return;
+    }
+    int out = p->logFds[k] >= 0 ? p->logFds[k] : devNullFd;
+    for (;;) {
+        ssize_t n;
+        if (k == 0 && p->capturedLen < captureLimit) {
+            if (p->captured == NULL) {
+                p->captured = (char*)malloc(captureLimit);
+                if (!p->captured) {
+                    perror("Failed to allocate capture buffer");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            n = read(in, p->captured + p->capturedLen, captureLimit - p->capturedLen);
+            if (n > 0) {
+                if (write(out, p->captured + p->capturedLen, (size_t)n) != n) {
+                    perror("Failed to write job log");
+                }
+                p->capturedLen += (size_t)n;
+            }
+        } else {
+            n = splice(in, NULL, out, NULL, 1 << 16, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        }
+        if (n > 0) {
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return;
+        }
+        // Fin de fichero, o un error del que no hay vuelta atrás
+        closeOutput(p, k);
+        return;
+    }
+}
+
+// El hijo ya se ha recogido: lo que quede en las tuberías es lo último
+// (si un nieto las mantiene abiertas, lo que escriba después se pierde)
+void finishOutput(Process *p) {
+    for (int k = 0; k < 2; k++) {
+        drainOutput(p, k);
+        closeOutput(p, k);
+    }
+}
+
+// ------------------ Expulsión ------------------
+
+// Cómo se para y se reanuda un trabajo y cómo se mide su CPU. Por defecto
+// con SIGSTOP/SIGCONT al hijo directo. Con -P cgroup cada trabajo va a su
+// propia hoja de cgroup v2 y se congela entero con cgroup.freeze: también
+// sus hijos, y sin usar las señales de control de trabajos, que quedan para
+// el propio trabajo. La CPU sale de cpu.stat, que incluye a los nietos. Si
+// cgroupfs no existe o no se puede escribir se vuelve a las señales; un
+// trabajo cuya hoja falla usa también señales.
+typedef struct PreemptBackend {
+    const char *name;
+    void (*prepare)(Process *p);            // Antes de lanzarlo (opcional)
+    void (*launched)(Process *p, pid_t pid); // Tras lanzarlo (opcional)
+    void (*stop)(Process *p);
+    void (*resume)(Process *p);
+    long long (*cpuNs)(Process *p);          // CPU en ns (-1 = desconocida)
+    void (*release)(Process *p);             // Ya recogido (opcional)
+} PreemptBackend;
+
+// CPU total consumida por pid en ns. schedstat tiene precisión de ns; si no
+// está disponible se usa utime+stime de /proc/<pid>/stat (en ticks).
+long long readCpuNs(pid_t pid) {
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/proc/%d/schedstat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (n > 0) {
+            buf[n] = '\0';
+            return atoll(buf);
+        }
+    }
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    // El nombre (campo 2) puede tener espacios: se cuenta desde el último ')'
+    char *s = strrchr(buf, ')');
+    unsigned long utime, stime;
+    if (s == NULL || sscanf(s + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                            &utime, &stime) != 2) {
+        return -1;
+    }
+    return (long long)(utime + stime) * (1000000000LL / sysconf(_SC_CLK_TCK));
+}
+
+void signalStop(Process *p) {
+    kill(p->pid, SIGSTOP);
+}
+
+void signalResume(Process *p) {
+    kill(p->pid, SIGCONT);
+}
+
+long long signalCpuNs(Process *p) {
+    return readCpuNs(p->pid);
+}
+
+PreemptBackend signalBackend = {
+    "signal", NULL, NULL, signalStop, signalResume, signalCpuNs, NULL
+};
+
+char cgroupBase[4096];  // Directorio del planificador: <cgroup propio>/scheduler.<pid>
+int cgroupBaseFd = -1;
+
+// Escribe value en el fichero name de la hoja dirFd
+int cgroupWrite(int dirFd, const char *name, const char *value) {
+    int fd = openat(dirFd, name, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t len = (ssize_t)strlen(value);
+    int ok = write(fd, value, (size_t)len) == len;
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+// Crea cgroupBase bajo el cgroup v2 en el que estamos. -1 si no se puede.
+int initCgroupBase() {
+    char line[4096], mount[1024] = "", own[2048] = "";
+    FILE *f = fopen("/proc/self/mountinfo", "r");
+    if (!f) {
+        return -1;
+    }
+    // ... <punto de montaje> ... - cgroup2 ...
+    while (fgets(line, sizeof(line), f)) {
+        if (strstr(line, " - cgroup2 ") != NULL &&
+            sscanf(line, "%*s %*s %*s %*s %1023s", mount) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    f = fopen("/proc/self/cgroup", "r");
+    if (!f) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "0::", 3) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            const char *path = strcmp(line + 3, "/") == 0 ? "" : line + 3;
+            size_t len = strlen(path);
+            if (len >= sizeof(own)) {
+                fclose(f);
+                return -1; // Ruta truncada: mejor sin cgroups que en otro sitio
+            }
+            memcpy(own, path, len + 1);
+            break;
+        }
+    }
+    fclose(f);
+    if (mount[0] == '\0') {
+        return -1;
+    }
+    int n = snprintf(cgroupBase, sizeof(cgroupBase), "%s%s/scheduler.%d", mount, own,
+                     (int)getpid());
+    if (n < 0 || (size_t)n >= sizeof(cgroupBase) || mkdir(cgroupBase, 0755) == -1) {
+        return -1;
+    }
+    cgroupBaseFd = open(cgroupBase, O_DIRECTORY | O_CLOEXEC);
+    if (cgroupBaseFd < 0 || faccessat(cgroupBaseFd, "cgroup.freeze", W_OK, 0) != 0) {
+        // Kernel sin freezer de v2 (anterior a 5.2)
+        if (cgroupBaseFd >= 0) {
+            close(cgroupBaseFd);
+            cgroupBaseFd = -1;
+        }
+        rmdir(cgroupBase);
+        return -1;
+    }
+    return 0;
+}
+
+void cgroupPrepare(Process *p) {
+    char name[32];
+    snprintf(name, sizeof(name), "job-%u", p->jobNo);
+    if (mkdirat(cgroupBaseFd, name, 0755) == -1 && errno != EEXIST) {
+        return;
+    }
+    p->cgroupFd = openat(cgroupBaseFd, name, O_DIRECTORY | O_CLOEXEC);
+    if (p->cgroupFd >= 0) {
+        childCgroupFd = openat(p->cgroupFd, "cgroup.procs", O_WRONLY | O_CLOEXEC);
+    }
+}
+
+// El hijo ya se metió solo; por si no pudo, lo intenta el padre. Si tampoco
+// entra, ese trabajo se para con señales.
+void cgroupLaunched(Process *p, pid_t pid) {
+    if (childCgroupFd >= 0) {
+        close(childCgroupFd);
+        childCgroupFd = -1;
+    }
+    if (p->cgroupFd < 0 || pid <= 0) {
+        return;
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", (int)pid);
+    if (cgroupWrite(p->cgroupFd, "cgroup.procs", buf) == -1) {
+        perror("Failed to move job into its cgroup");
+        close(p->cgroupFd);
+        p->cgroupFd = -1;
+    }
+}
+
+void cgroupStop(Process *p) {
+    if (p->cgroupFd < 0 || cgroupWrite(p->cgroupFd, "cgroup.freeze", "1") == -1) {
+        signalStop(p);
+    }
+}
+
+void cgroupResume(Process *p) {
+    if (p->cgroupFd < 0 || cgroupWrite(p->cgroupFd, "cgroup.freeze", "0") == -1) {
+        signalResume(p);
+    }
+}
+
+// usage_usec de cpu.stat: CPU exacta de todo el árbol del trabajo
+long long cgroupCpuNs(Process *p) {
+    if (p->cgroupFd < 0) {
+        return readCpuNs(p->pid);
+    }
+    char buf[512];
+    int fd = openat(p->cgroupFd, "cpu.stat", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return readCpuNs(p->pid);
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    long long usec;
+    if (n <= 0) {
+        return readCpuNs(p->pid);
+    }
+    buf[n] = '\0';
+    if (sscanf(buf, "usage_usec %lld", &usec) != 1) {
+        return readCpuNs(p->pid);
+    }
+    return usec * 1000;
+}
+
+// Mata lo que quede dentro (nietos) y borra la hoja. Si aún no está vacía
+// se queda y la borra closeCgroupBase.
+void cgroupRelease(Process *p) {
+    if (p->cgroupFd < 0) {
+        return;
+    }
+    cgroupWrite(p->cgroupFd, "cgroup.kill", "1");
+    close(p->cgroupFd);
+    p->cgroupFd = -1;
+    char name[32];
+    snprintf(name, sizeof(name), "job-%u", p->jobNo);
+    unlinkat(cgroupBaseFd, name, AT_REMOVEDIR);
+}
+
+void closeCgroupBase() {
+    if (cgroupBaseFd < 0) {
+        return;
+    }
+    DIR *d = fdopendir(dup(cgroupBaseFd));
+    struct dirent *e;
+    while (d != NULL && (e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, "job-", 4) == 0) {
+            unlinkat(cgroupBaseFd, e->d_name, AT_REMOVEDIR);
+        }
+    }
+    if (d != NULL) {
+        closedir(d);
+    }
+    close(cgroupBaseFd);
+    cgroupBaseFd = -1;
+    if (rmdir(cgroupBase) == -1) {
+        perror("Failed to remove scheduler cgroup");
+    }
+}
+
+PreemptBackend cgroupBackend = {
+    "cgroup", cgroupPrepare, cgroupLaunched, cgroupStop, cgroupResume, cgroupCpuNs, cgroupRelease
+};
+
+PreemptBackend *preemptBackend = &signalBackend;
+
+// ------------------ Memoria ------------------
+
+// Con -M MB los trabajos nuevos solo se lanzan mientras la memoria
+// comprometida quepa en el presupuesto; los que no caben esperan fuera de la
+// política (memWaiting) para no bloquear a los que ya corrieron, y vuelven
+// en orden cuando se libera su reserva. Cada trabajo lanzado reserva su pico
+// esperado: el que declara con mem= o, si no, el mayor ru_maxrss que dio
+// wait4 para el mismo ejecutable en esta ejecución (0 si aún no se ha visto
+// ninguno). Cada MEM_SAMPLE_MS se lee la residente de cada hijo de
+// /proc/PID/statm (pread sobre un fd abierto al lanzarlo) y la reserva sube
+// si el trabajo ya usa más. Si la residente total no cabe se para el trabajo
+// de menor prioridad (y, entre ellos, el más grande) de los que corren, y no
+// vuelve a la política hasta que la residente baje de MEM_RESUME del
+// presupuesto. Con un solo trabajo vivo no se retiene nada: si no cabe solo,
+// no va a caber nunca. En --simulate no hay memoria que controlar.
+#define EV_MEMORY 10 // timerfd del muestreo de memoria
+#define MEM_SAMPLE_MS 100
+#define MEM_RESUME 0.9
+
+long memBudgetKb = 0;        // 0 = sin control de memoria
+long memCommittedKb = 0;     // Reservas de los trabajos lanzados y sin recoger
+long memResidentKb = 0;      // Residente total en el último muestreo
+long memPeakCommittedKb = 0;
+long pageKb = 4;
+int memTimerFd = -1;
+int memHolds = 0;            // Trabajos que tuvieron que esperar memoria
+int memStops = 0;            // Veces que se paró un trabajo por presión
+Queue *memWaiting = NULL;    // Nuevos que no caben, fuera de la política
+Queue *memParked = NULL;     // Parados por presión, fuera de la política
+
+// Mayor ru_maxrss visto por ejecutable. La clave es el nombre internado,
+// que vive hasta el final, así que no se copia.
+typedef struct MemPeak {
+    const char *name; // NULL = hueco libre
+    long peakKb;
+} MemPeak;
+
+MemPeak *memPeaks = NULL;
+int memPeaksCapacity = 0; // Siempre potencia de 2
+int memPeaksCount = 0;
+
+int memoryControl() {
+    return memBudgetKb > 0;
+}
+
+MemPeak* memPeakSlot(MemPeak *entries, int capacity, const char *name) {
+    unsigned mask = (unsigned)(capacity - 1);
+    unsigned i = stringHash(name, strlen(name)) & mask;
+    while (entries[i].name != NULL && strcmp(entries[i].name, name) != 0) {
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
+
+void memPeaksGrow() {
+    int capacity = memPeaksCapacity ? memPeaksCapacity * 2 : 16;
+    MemPeak *entries = (MemPeak*)calloc(capacity, sizeof(MemPeak));
+    if (!entries) {
+        perror("Failed to allocate memory for memory peaks");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < memPeaksCapacity; i++) {
+        if (memPeaks[i].name != NULL) {
+            *memPeakSlot(entries, capacity, memPeaks[i].name) = memPeaks[i];
+        }
+    }
+    free(memPeaks);
+    memPeaks = entries;
+    memPeaksCapacity = capacity;
+}
+
+// Pico esperado de p en KB
+long expectedPeakKb(Process *p) {
+    if (p->memKb > 0) {
+        return p->memKb;
+    }
+    if (memPeaksCount == 0) {
+        return 0;
+    }
+    return memPeakSlot(memPeaks, memPeaksCapacity, p->executableName)->peakKb;
+}
+
+void learnPeak(Process *p) {
+    if ((memPeaksCount + 1) * 2 > memPeaksCapacity) {
+        memPeaksGrow();
+    }
+    MemPeak *e = memPeakSlot(memPeaks, memPeaksCapacity, p->executableName);
+    if (e->name == NULL) {
+        e->name = p->executableName;
+        e->peakKb = 0;
+        memPeaksCount++;
+    }
+    if (p->maxRssKb > e->peakKb) {
+        e->peakKb = p->maxRssKb;
+    }
+}
+
+void initMemory() {
+    pageKb = sysconf(_SC_PAGESIZE) / 1024;
+    memWaiting = createQueue();
+    memParked = createQueue();
+    memTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (memTimerFd == -1) {
+        perror("timerfd_create failed");
+        exit(EXIT_FAILURE);
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_nsec = MEM_SAMPLE_MS * 1000000L;
+    its.it_interval = its.it_value;
+    timerfd_settime(memTimerFd, 0, &its, NULL);
+    watchFd(memTimerFd, EV_MEMORY, 0);
+}
+
+void closeMemory() {
+    close(memTimerFd);
+    destroyQueue(memWaiting);
+    destroyQueue(memParked);
+    free(memPeaks);
+}
+
+// ¿Se puede lanzar p ya? Los que ya corrieron tienen su reserva hecha
+int memoryAdmits(Process *p) {
+    return p->pid != -1 || completions.count == 0 ||
+           memCommittedKb + expectedPeakKb(p) <= memBudgetKb;
+}
+
+void memHold(Process *p) {
+    memHolds++;
+    logMsg(LOG_DEBUG, "Memory: holding %s (needs %ld MB, %ld of %ld MB committed)\n",
+           p->executableName, expectedPeakKb(p) / 1024, memCommittedKb / 1024,
+           memBudgetKb / 1024);
+    enqueue(memWaiting, p);
+}
+
+// Los que esperaban memoria y ya caben, en orden de llegada
+Process* memReady() {
+    // Los cancelados mientras esperaban no deben frenar a los de detrás
+    while (!isQueueEmpty(memWaiting) && queueFront(memWaiting)->status == EXITED) {
+        freeProcess(dequeue(memWaiting));
+    }
+    if (isQueueEmpty(memWaiting) || !memoryAdmits(queueFront(memWaiting))) {
+        return NULL;
+    }
+    return dequeue(memWaiting);
+}
+
+void memLaunched(Process *p, pid_t pid) {
+    p->reservedKb = expectedPeakKb(p);
+    memCommittedKb += p->reservedKb;
+    if (memCommittedKb > memPeakCommittedKb) {
+        memPeakCommittedKb = memCommittedKb;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+    p->statmFd = open(path, O_RDONLY | O_CLOEXEC);
+}
+
+// Recogido: libera su reserva y aprende su pico
+void memFinished(Process *p) {
+    memCommittedKb -= p->reservedKb;
+    p->reservedKb = 0;
+    if (p->statmFd >= 0) {
+        close(p->statmFd);
+        p->statmFd = -1;
+    }
+    learnPeak(p);
+}
+
+// Residente de p en KB (segundo campo de statm, en páginas)
+long residentKb(Process *p) {
+    char buf[128];
+    ssize_t n = (p->statmFd >= 0) ? pread(p->statmFd, buf, sizeof(buf) - 1, 0) : -1;
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+    long size, resident;
+    if (sscanf(buf, "%ld %ld", &size, &resident) != 2) {
+        return 0;
+    }
+    return resident * pageKb;
+}
+
+// Residente de todos los hijos vivos (los de la tabla de finalización)
+void memSample() {
+    long total = 0;
+    for (int i = 0; i < completions.capacity; i++) {
+        if (completions.pids[i] == 0) {
+            continue;
+        }
+        Process *p = completions.procs[i];
+        long kb = residentKb(p);
+        total += kb;
+        if (kb > p->reservedKb) {
+            memCommittedKb += kb - p->reservedKb;
+            p->reservedKb = kb;
+        }
+    }
+    memResidentKb = total;
+    if (memCommittedKb > memPeakCommittedKb) {
+        memPeakCommittedKb = memCommittedKb;
+    }
+}
+
+void printMemoryStats() {
+    logMsg(LOG_INFO, "Memory: budget %ld MB, peak committed %ld MB, %d admission holds, "
+           "%d stops under pressure\n", memBudgetKb / 1024, memPeakCommittedKb / 1024,
+           memHolds, memStops);
+}
+
+// ------------------ Políticas ------------------
+
+// Una política decide en qué orden salen los procesos listos y con qué
+// quantum se despachan. Los slots, el lanzamiento y el bucle de eventos son
+// comunes a todas. Los trabajos nuevos y los expulsados entran por push.
+typedef struct Policy {
+    const char *name;
+    void (*push)(Process *p);              // p pasa a estar listo
+    Process* (*pop)(void);                 // Siguiente a despachar (hay alguno)
+    Process* (*peek)(void);                // Como pop pero sin sacarlo
+    int (*empty)(void);
+    int (*quantum)(Process *p);            // ms de este despacho (0 = hasta que termine)
+    void (*expired)(Process *p);           // p agotó su quantum (NULL = nada)
+    int (*better)(Process *a, Process *b); // ¿a debe quitarle la CPU a b? (NULL = nunca)
+    int periodMs;                          // Si > 0, se llama a periodic cada periodMs
+    void (*periodic)(void);
+    int runLimitMs;                        // Tras este tiempo de CPU se mata (0 = sin tope)
+    void (*charge)(Process *p);            // p acaba de pararse (NULL = nada)
+    void (*finished)(Process *p);          // p terminó y ya se recogió (NULL = nada)
+    void (*report)(void);                  // Resumen al final (NULL = nada)
+    int (*admit)(Process *p);              // Al llegar: 0 = se rechaza (NULL = todos)
+} Policy;
+
+Policy *policy = NULL;
+
+// FCFS y RR comparten una única cola FIFO de listos
+Queue *readyQueue = NULL;
+int rrQuantumMs = 0;
+
+void fifoPush(Process *p) {
+    enqueue(readyQueue, p);
+}
+
+Process* fifoPop() {
+    return dequeue(readyQueue);
+}
+
+Process* fifoPeek() {
+    return queueFront(readyQueue);
+}
+
+int fifoEmpty() {
+    return isQueueEmpty(readyQueue);
+}
+
+int fcfsQuantum(Process *p) {
+    return 0;
+}
+
+int rrQuantum(Process *p) {
+    return rrQuantumMs;
+}
+
+Policy fcfsPolicy = {
+    .name = "FCFS", .push = fifoPush, .pop = fifoPop, .peek = fifoPeek,
+    .empty = fifoEmpty, .quantum = fcfsQuantum,
+};
+
+Policy rrPolicy = {
+    .name = "RR", .push = fifoPush, .pop = fifoPop, .peek = fifoPeek,
+    .empty = fifoEmpty, .quantum = rrQuantum,
+    .runLimitMs = 5000, // Ej. 5s
+};
+
+// MLFQ: una cola FIFO por nivel, cada una con su quantum. Los trabajos
+// entran en el nivel 0, bajan uno al agotar el quantum y cada boostMs vuelven
+// todos al nivel 0 para que los largos no mueran de hambre. Un trabajo de un
+// nivel más alto expulsa al que esté corriendo en uno más bajo.
+#define MLFQ_MAX_LEVELS 16
+
+Queue *mlfqLevels[MLFQ_MAX_LEVELS];
+int mlfqQuanta[MLFQ_MAX_LEVELS];
+int mlfqNumLevels = 0;
+int mlfqReady = 0; // Procesos en todas las colas
+
+void mlfqPush(Process *p) {
+    enqueue(mlfqLevels[p->level], p);
+    mlfqReady++;
+}
+
+Process* mlfqPeek() {
+    for (int l = 0; l < mlfqNumLevels; l++) {
+        if (!isQueueEmpty(mlfqLevels[l])) {
+            return queueFront(mlfqLevels[l]);
+        }
+    }
+    return NULL;
+}
+
+Process* mlfqPop() {
+    for (int l = 0; l < mlfqNumLevels; l++) {
+        if (!isQueueEmpty(mlfqLevels[l])) {
+            mlfqReady--;
+            return dequeue(mlfqLevels[l]);
+        }
+    }
+    return NULL;
+}
+
+int mlfqEmpty() {
+    return mlfqReady == 0;
+}
+
+int mlfqQuantum(Process *p) {
+    return mlfqQuanta[p->level];
+}
+
+void mlfqExpired(Process *p) {
+    if (p->level < mlfqNumLevels - 1) {
+        p->level++;
+    }
+}
+
+int mlfqBetter(Process *a, Process *b) {
+    return a->level < b->level;
+}
+
+// Subida periódica: todo vuelve al nivel 0 conservando el orden por niveles
+void mlfqBoost() {
+    for (int l = 1; l < mlfqNumLevels; l++) {
+        while (!isQueueEmpty(mlfqLevels[l])) {
+            Process *p = dequeue(mlfqLevels[l]);
+            p->level = 0;
+            enqueue(mlfqLevels[0], p);
+        }
+    }
+    for (int i = 0; i < numSlots; i++) {
+        if (slots[i].proc != NULL) {
+            slots[i].proc->level = 0;
+        }
+    }
+}
+
+Policy mlfqPolicy = {
+    .name = "MLFQ", .push = mlfqPush, .pop = mlfqPop, .peek = mlfqPeek,
+    .empty = mlfqEmpty, .quantum = mlfqQuantum, .expired = mlfqExpired,
+    .better = mlfqBetter, .periodic = mlfqBoost,
+};
+
+// quanta es una lista "q0,q1,..." (uno por nivel, en ms). Devuelve -1 si no
+// es válida.
+int initMlfq(const char *quanta, int boostMs) {
+    char buf[256];
+    if (strlen(quanta) >= sizeof(buf) || boostMs <= 0) {
+        return -1;
+    }
+    strcpy(buf, quanta);
+    mlfqNumLevels = 0;
+    for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        int q = atoi(tok);
+        if (q <= 0 || mlfqNumLevels == MLFQ_MAX_LEVELS) {
+            return -1;
+        }
+        mlfqQuanta[mlfqNumLevels] = q;
+        mlfqLevels[mlfqNumLevels] = createQueue();
+        mlfqNumLevels++;
+    }
+    mlfqPolicy.periodMs = boostMs;
+    return mlfqNumLevels > 0 ? 0 : -1;
+}
+
+void destroyMlfq() {
+    for (int l = 0; l < mlfqNumLevels; l++) {
+        while (!isQueueEmpty(mlfqLevels[l])) {
+            freeProcess(dequeue(mlfqLevels[l]));
+        }
+        destroyQueue(mlfqLevels[l]);
+    }
+}
+
+// SJF y SRTF: montículo ordenado por la duración que predice el historial.
+// SJF deja terminar al que está corriendo; SRTF lo expulsa si llega uno al
+// que le queda menos.
+Heap sjfHeap;
+
+// Lo que se espera que le quede a p, contando el quantum en curso
+double predictedRemaining(Process *p) {
+    double ms = p->predictedMs - p->ranMs;
+    if (p->slot >= 0) {
+        ms -= elapsedMs(slots[p->slot].sliceStartSec);
+    }
+    return ms > 0 ? ms : 0;
+}
+
+int sjfLess(Process *a, Process *b) {
+    if (a->predictedMs != b->predictedMs) {
+        return a->predictedMs < b->predictedMs;
+    }
+    return a->arrivalSec < b->arrivalSec;
+}
+
+int srtfLess(Process *a, Process *b) {
+    double ra = predictedRemaining(a), rb = predictedRemaining(b);
+    if (ra != rb) {
+        return ra < rb;
+    }
+    return a->arrivalSec < b->arrivalSec;
+}
+
+void sjfPush(Process *p) {
+    heapPush(&sjfHeap, p);
+}
+
+Process* sjfPop() {
+    return heapPop(&sjfHeap);
+}
+
+Process* sjfPeek() {
+    return heapTop(&sjfHeap);
+}
+
+int sjfEmpty() {
+    return sjfHeap.count == 0;
+}
+
+int srtfBetter(Process *a, Process *b) {
+    return predictedRemaining(a) < predictedRemaining(b);
+}
+
+Policy sjfPolicy = {
+    .name = "SJF", .push = sjfPush, .pop = sjfPop, .peek = sjfPeek,
+    .empty = sjfEmpty, .quantum = fcfsQuantum,
+};
+
+Policy srtfPolicy = {
+    .name = "SRTF", .push = sjfPush, .pop = sjfPop, .peek = sjfPeek,
+    .empty = sjfEmpty, .quantum = fcfsQuantum, .better = srtfBetter,
+};
+
+// EDF: montículo ordenado por plazo absoluto (llegada + deadline=); los que
+// no tienen plazo van detrás, por orden de llegada. Un trabajo con un plazo
+// más cercano expulsa al que corre. Al llegar se hace la prueba de
+// utilización: la suma de C/D (duración esperada entre plazo relativo) de
+// los admitidos que no han terminado no puede pasar del número de slots; si
+// pasaría, el trabajo se rechaza en lugar de hacer que fallen otros. Con un
+// slot, si las duraciones esperadas aciertan, basta para que EDF cumpla todos
+// los plazos (es conservadora: no descuenta lo que ya han corrido); con
+// varios slots es solo una aproximación.
+Heap edfHeap;
+double edfUtilization = 0;
+int edfRejected = 0;
+int edfMissed = 0;
+double *edfLateness = NULL; // ms (negativo = terminó antes de su plazo)
+int edfJobs = 0;
+int edfLatenessCapacity = 0;
+
+int edfLess(Process *a, Process *b) {
+    if (a->deadlineSec != b->deadlineSec) {
+        return a->deadlineSec < b->deadlineSec;
+    }
+    return a->arrivalSec < b->arrivalSec;
+}
+
+void edfPush(Process *p) {
+    heapPush(&edfHeap, p);
+}
+
+Process* edfPop() {
+    return heapPop(&edfHeap);
+}
+
+Process* edfPeek() {
+    return heapTop(&edfHeap);
+}
+
+int edfEmpty() {
+    return edfHeap.count == 0;
+}
+
+int edfBetter(Process *a, Process *b) {
+    return a->deadlineSec < b->deadlineSec;
+}
+
+double edfDensity(Process *p) {
+    return p->predictedMs / p->deadlineMs;
+}
+
+int edfAdmit(Process *p) {
+    if (p->deadlineMs == 0) {
+        return 1;
+    }
+    double u = edfDensity(p);
+    if (edfUtilization + u > numSlots) {
+        logMsg(LOG_INFO, "Rejecting %s: utilization would be %.2f with %d slots "
+               "(expects %.0f ms, deadline %d ms)\n", p->executableName,
+               edfUtilization + u, numSlots, p->predictedMs, p->deadlineMs);
+        edfRejected++;
+        return 0;
+    }
+    edfUtilization += u;
+    p->deadlineSec = p->arrivalSec + p->deadlineMs / 1000.0;
+    return 1;
+}
+
+void edfFinished(Process *p) {
+    if (p->deadlineMs == 0) {
+        return;
+    }
+    edfUtilization -= edfDensity(p);
+    double lateMs = (nowSeconds() - p->deadlineSec) * 1000;
+    if (lateMs > 0) {
+        edfMissed++;
+        logMsg(LOG_INFO, "Deadline missed: %s (PID: %d) %.1f ms late\n",
+               p->executableName, p->pid, lateMs);
+    }
+    if (edfJobs == edfLatenessCapacity) {
+        edfLatenessCapacity = edfLatenessCapacity ? edfLatenessCapacity * 2 : 256;
+        double *l = (double*)realloc(edfLateness, edfLatenessCapacity * sizeof(double));
+        if (!l) {
+            perror("Failed to allocate memory for lateness");
+            exit(EXIT_FAILURE);
+        }
+        edfLateness = l;
+    }
+    edfLateness[edfJobs++] = lateMs;
+}
+
+void edfReport() {
+    logMsg(LOG_INFO, "EDF: %d jobs with deadline, %d missed, %d rejected at admission\n",
+           edfJobs, edfMissed, edfRejected);
+    if (edfJobs > 0) {
+        qsort(edfLateness, edfJobs, sizeof(double), compareDoubles);
+        logMsg(LOG_INFO, "Lateness (ms): min %.1f, p50 %.1f, p95 %.1f, p99 %.1f, max %.1f\n",
+               edfLateness[0], percentile(edfLateness, edfJobs, 0.50),
+               percentile(edfLateness, edfJobs, 0.95), percentile(edfLateness, edfJobs, 0.99),
+               edfLateness[edfJobs - 1]);
+    }
+}
+
+Policy edfPolicy = {
+    .name = "EDF", .push = edfPush, .pop = edfPop, .peek = edfPeek,
+    .empty = edfEmpty, .quantum = fcfsQuantum, .better = edfBetter,
+    .finished = edfFinished, .report = edfReport, .admit = edfAdmit,
+};
+
+// FAIR: como CFS. Cada proceso acumula un tiempo virtual (vruntime) igual a
+// la CPU real que ha consumido (de /proc/<pid>/schedstat) escalada por su
+// peso, que depende del nice; siempre se despacha el de menor vruntime. Los
+// listos están en un montículo de emparejamiento (pairing heap) enlazado por
+// los propios registros del pool, sin memoria extra.
+#define FAIR_NICE0_WEIGHT 1024
+#define FAIR_MIN_SLICE_MS 1
+
+// Pesos de CFS para nice -20..19: cada nivel da ~10% más o menos de CPU
+static const int fairWeights[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45, 36, 29, 23, 18, 15,
+};
+
+unsigned fairRoot = POOL_NONE;
+unsigned fairCount = 0;
+long fairQueuedWeight = 0; // Suma de pesos de los que esperan en el montículo
+double fairMinVruntime = 0; // Nunca decrece: punto de entrada de los nuevos
+int fairLatencyMs = 0;      // Periodo en el que todos deberían correr una vez
+
+// Para el índice de Jain al final
+double fairSum = 0, fairSumSq = 0;
+int fairJobs = 0;
+
+static inline int fairWeight(Process *p) {
+    return fairWeights[p->nice + 20];
+}
+
+// Suma al vruntime de p la CPU consumida desde la última lectura
+void fairAccount(Process *p, long long cpuNs) {
+    if (cpuNs < p->cpuNs) {
+        return;
+    }
+    p->vruntime += (cpuNs - p->cpuNs) / 1e6 * FAIR_NICE0_WEIGHT / fairWeight(p);
+    p->cpuNs = cpuNs;
+}
+
+static inline int fairLess(unsigned a, unsigned b) {
+    Process *pa = processAt(a), *pb = processAt(b);
+    if (pa->vruntime != pb->vruntime) {
+        return pa->vruntime < pb->vruntime;
+    }
+    return pa->arrivalSec < pb->arrivalSec;
+}
+
+// Une dos montículos: la raíz mayor pasa a ser el primer hijo de la menor
+unsigned phMeld(unsigned a, unsigned b) {
+    if (a == POOL_NONE) {
+        return b;
+    }
+    if (b == POOL_NONE) {
+        return a;
+    }
+    if (fairLess(b, a)) {
+        unsigned tmp = a;
+        a = b;
+        b = tmp;
+    }
+    processAt(b)->phSibling = processAt(a)->phChild;
+    processAt(a)->phChild = b;
+    return a;
+}
+
+// Dos pasadas sobre la lista de hijos: une por parejas de izquierda a
+// derecha y luego acumula de derecha a izquierda. Sin recursión.
+unsigned phMergePairs(unsigned first) {
+    unsigned stack = POOL_NONE; // Parejas ya unidas, enlazadas por phSibling
+    while (first != POOL_NONE) {
+        unsigned a = first;
+        unsigned b = processAt(a)->phSibling;
+        unsigned merged;
+        if (b == POOL_NONE) {
+            first = POOL_NONE;
+            merged = a;
+        } else {
+            first = processAt(b)->phSibling;
+            processAt(b)->phSibling = POOL_NONE;
+            processAt(a)->phSibling = POOL_NONE;
+            merged = phMeld(a, b);
+        }
+        processAt(merged)->phSibling = stack;
+        stack = merged;
+    }
+    unsigned root = POOL_NONE;
+    while (stack != POOL_NONE) {
+        unsigned next = processAt(stack)->phSibling;
+        processAt(stack)->phSibling = POOL_NONE;
+        root = phMeld(root, stack);
+        stack = next;
+    }
+    return root;
+}
+
+void fairPush(Process *p) {
+    if (p->pid == -1 && p->vruntime < fairMinVruntime) {
+        // Un recién llegado no puede reclamar la CPU que no ha esperado
+        p->vruntime = fairMinVruntime;
+    }
+    p->phChild = POOL_NONE;
+    p->phSibling = POOL_NONE;
+    fairRoot = phMeld(fairRoot, p->id);
+    fairCount++;
+    fairQueuedWeight += fairWeight(p);
+}
+
+Process* fairPeek() {
+    return fairRoot == POOL_NONE ? NULL : processAt(fairRoot);
+}
+
+Process* fairPop() {
+    Process *p = processAt(fairRoot);
+    fairRoot = phMergePairs(p->phChild);
+    fairCount--;
+    fairQueuedWeight -= fairWeight(p);
+    if (p->vruntime > fairMinVruntime) {
+        fairMinVruntime = p->vruntime;
+    }
+    return p;
+}
+
+int fairEmpty() {
+    return fairCount == 0;
+}
+
+// Cada uno recibe del periodo la parte que le toca por peso
+int fairQuantum(Process *p) {
+    long total = fairQueuedWeight;
+    for (int i = 0; i < numSlots; i++) {
+        if (slots[i].proc != NULL) {
+            total += fairWeight(slots[i].proc);
+        }
+    }
+    long ms = (long)fairLatencyMs * numSlots * fairWeight(p) / total;
+    if (ms > fairLatencyMs) {
+        ms = fairLatencyMs;
+    }
+    return ms < FAIR_MIN_SLICE_MS ? FAIR_MIN_SLICE_MS : (int)ms;
+}
+
+void fairCharge(Process *p) {
+    fairAccount(p, simulating ? (long long)(p->simCpuMs * 1e6) : preemptBackend->cpuNs(p));
+}
+
+// Al terminar se cobra lo último con el rusage de wait4 y se anota el
+// reparto: CPU recibida por segundo de vida, normalizada por el peso
+void fairFinished(Process *p) {
+    fairAccount(p, (p->cpuUserUs + p->cpuSysUs) * 1000LL);
+    double lifetime = nowSeconds() - p->arrivalSec;
+    if (lifetime <= 0) {
+        return;
+    }
+    double x = p->cpuNs / 1e9 / lifetime * FAIR_NICE0_WEIGHT / fairWeight(p);
+    fairSum += x;
+    fairSumSq += x * x;
+    fairJobs++;
+}
+
+// Índice de Jain: (sum x)^2 / (n * sum x^2), 1 = reparto perfecto
+void fairReport() {
+    if (fairJobs > 0 && fairSumSq > 0) {
+        logMsg(LOG_INFO, "Jain's fairness index: %.4f (%d jobs)\n",
+               fairSum * fairSum / (fairJobs * fairSumSq), fairJobs);
+    }
+}
+
+void destroyFair() {
+    while (!fairEmpty()) {
+        freeProcess(fairPop());
+    }
+}
+
+Policy fairPolicy = {
+    .name = "FAIR", .push = fairPush, .pop = fairPop, .peek = fairPeek,
+    .empty = fairEmpty, .quantum = fairQuantum, .charge = fairCharge,
+    .finished = fairFinished, .report = fairReport,
+};
+
+// PRIO: una cola FIFO por prioridad (0..139, la de prio=) y un bitmap de
+// las que no están vacías, así que elegir el siguiente es buscar el primer
+// bit con __builtin_ctzll en PRIO_WORDS palabras, haya los trabajos que haya.
+// Dentro de una prioridad se turnan con el quantum dado y un trabajo más
+// prioritario expulsa al que corre. Para que nadie muera de hambre, los que
+// llevan PRIO_AGE_MS esperando en su nivel suben uno en cada pasada de
+// envejecimiento (cada PRIO_AGE_MS); al agotar un quantum vuelven a su
+// prioridad de base. level es la prioridad efectiva.
+#define PRIO_LEVELS 140
+#define PRIO_WORDS ((PRIO_LEVELS + 63) / 64)
+#define PRIO_AGE_MS 1000
+
+Queue *prioLevels[PRIO_LEVELS];
+uint64_t prioBitmap[PRIO_WORDS];
+int prioReady = 0;
+int prioQuantumMs = 0;
+long prioPromotions = 0;
+
+static inline void prioMark(int l) {
+    prioBitmap[l >> 6] |= 1ULL << (l & 63);
+}
+
+static inline void prioUnmark(int l) {
+    prioBitmap[l >> 6] &= ~(1ULL << (l & 63));
+}
+
+// Nivel no vacío más prioritario (-1 si no hay ninguno)
+static inline int prioFirst() {
+    for (int w = 0; w < PRIO_WORDS; w++) {
+        if (prioBitmap[w] != 0) {
+            return w * 64 + __builtin_ctzll(prioBitmap[w]);
+        }
+    }
+    return -1;
+}
+
+void prioEnqueue(Process *p, int level) {
+    p->level = level;
+    p->levelSec = nowSeconds();
+    enqueue(prioLevels[level], p);
+    prioMark(level);
+}
+
+void prioPush(Process *p) {
+    // La primera vez entra con la prioridad del fichero
+    prioEnqueue(p, p->levelSec < 0 ? p->priority : p->level);
+    prioReady++;
+}
+
+Process* prioPeek() {
+    int l = prioFirst();
+    return l < 0 ? NULL : queueFront(prioLevels[l]);
+}
+
+Process* prioPop() {
+    int l = prioFirst();
+    if (l < 0) {
+        return NULL;
+    }
+    Process *p = dequeue(prioLevels[l]);
+    if (isQueueEmpty(prioLevels[l])) {
+        prioUnmark(l);
+    }
+    prioReady--;
+    return p;
+}
+
+int prioEmpty() {
+    return prioReady == 0;
+}
+
+int prioQuantum(Process *p) {
+    return prioQuantumMs;
+}
+
+void prioExpired(Process *p) {
+    p->level = p->priority;
+}
+
+int prioBetter(Process *a, Process *b) {
+    return a->level < b->level;
+}
+
+// Envejecimiento: cada cola está ordenada por levelSec, así que solo se
+// miran los primeros de cada nivel no vacío. Se recorre de más a menos
+// prioritario para que nadie suba dos niveles en la misma pasada.
+void prioAge() {
+    double cutoff = nowSeconds() - PRIO_AGE_MS / 1000.0;
+    for (int l = 1; l < PRIO_LEVELS; l++) {
+        if (!(prioBitmap[l >> 6] & (1ULL << (l & 63)))) {
+            continue;
+        }
+        Queue *q = prioLevels[l];
+        while (!isQueueEmpty(q) && queueFront(q)->levelSec <= cutoff) {
+            prioEnqueue(dequeue(q), l - 1);
+            prioPromotions++;
+        }
+        if (isQueueEmpty(q)) {
+            prioUnmark(l);
+        }
+    }
+}
+
+// Cambia la prioridad de base de p en caliente. Si espera en una cola se
+// mueve a la nueva (O(n) en su nivel); si corre, cuenta desde ya para las
+// expulsiones. Los retenidos fuera de la política la usan al volver.
+void prioSet(Process *p, int priority) {
+    priority = priority < 0 ? 0 : (priority >= PRIO_LEVELS ? PRIO_LEVELS - 1 : priority);
+    p->priority = priority;
+    if (p->levelSec >= 0 && p->slot < 0 && queueRemove(prioLevels[p->level], p)) {
+        if (isQueueEmpty(prioLevels[p->level])) {
+            prioUnmark(p->level);
+        }
+        prioEnqueue(p, priority);
+    } else {
+        p->level = priority;
+    }
+}
+
+void prioReport() {
+    logMsg(LOG_INFO, "PRIO: %ld promotions by aging\n", prioPromotions);
+}
+
+Policy prioPolicy = {
+    .name = "PRIO", .push = prioPush, .pop = prioPop, .peek = prioPeek,
+    .empty = prioEmpty, .quantum = prioQuantum, .expired = prioExpired,
+    .better = prioBetter, .periodMs = PRIO_AGE_MS, .periodic = prioAge,
+    .report = prioReport,
+};
+
+// Cambia la prioridad del trabajo número jobNo, esté en cola, retenido o
+// corriendo. Lo usan "!prio" en la entrada de trabajos y "prio" en el socket
+// de control. NULL si no se pudo.
+Process* changePriority(unsigned jobNo, int priority) {
+    Process *p = findJob(jobNo);
+    if (policy != &prioPolicy || p == NULL || p->status == EXITED) {
+        logMsg(LOG_ERROR, "Cannot change priority of job %u\n", jobNo);
+        return NULL;
+    }
+    prioSet(p, priority);
+    logMsg(LOG_INFO, "Priority of %s (job %u) set to %d\n", p->executableName, jobNo,
+           p->priority);
+    return p;
+}
+
+void initPrio() {
+    for (int l = 0; l < PRIO_LEVELS; l++) {
+        prioLevels[l] = createQueue();
+    }
+}
+
+void destroyPrio() {
+    if (prioLevels[0] == NULL) {
+        return;
+    }
+    while (!prioEmpty()) {
+        freeProcess(prioPop());
+    }
+    for (int l = 0; l < PRIO_LEVELS; l++) {
+        destroyQueue(prioLevels[l]);
+    }
+}
+
+// ------------------ Despacho ------------------
+
+// Contabilidad común (real y simulada) al poner p en el slot s
+void startSlice(Slot *s, Process *p) {
+    double now = nowSeconds();
+    p->waitSec += now - p->readySec;
+    if (p->firstRunSec < 0) {
+        p->firstRunSec = now;
+    }
+    p->slot = (int)(s - slots);
+    setStatus(p, RUNNING);
+    s->proc = p;
+    s->sliceStartSec = now;
+    s->quantum = policy->quantum(p);
+    p->quantumMs = s->quantum;
+}
+
+// Cambios de contexto (cada vez que un slot recibe un proceso), cuánto se
+// pasa cada quantum de lo programado (latencia del timerfd más la del bucle)
+// y lo que cuesta parar y reanudar a los expulsados
+typedef struct SwitchStats {
+    long switches;
+    long expirations;
+    double overshootUs;
+    double maxOvershootUs;
+    double costUs;
+} SwitchStats;
+
+SwitchStats switchStats = {0, 0, 0, 0, 0};
+
+void printSwitchStats() {
+    if (switchStats.expirations == 0) {
+        return;
+    }
+    logMsg(LOG_INFO, "Context switches: %ld, quantum overshoot mean %.1f us, max %.1f us\n",
+           switchStats.switches,
+           switchStats.overshootUs / switchStats.expirations,
+           switchStats.maxOvershootUs);
+}
+
+// Lanza (o reanuda) p en el slot s con el quantum que le da la política.
+// Devuelve -1 si no se pudo crear el hijo.
+int dispatch(Slot *s, Process *p) {
+    if (p->pid == -1) {
+        if (p->remainingTime <= 0) {
+            p->remainingTime = policy->runLimitMs;
+        }
+        if (capturingOutput()) {
+            prepareOutput(p);
+        }
+        if (preemptBackend->prepare) {
+            preemptBackend->prepare(p);
+        }
+        pid_t pid = launchProcess(p, s->cpu);
+        if (preemptBackend->launched) {
+            preemptBackend->launched(p, pid);
+        }
+        if (capturingOutput()) {
+            outputLaunched(p, pid);
+        }
+        if (pid < 0) {
+            return -1;
+        }
+        if (memoryControl()) {
+            memLaunched(p, pid);
+        }
+        p->pid = pid;
+        // Un pidfd sobre un zombi ya es legible, así que no hay carrera
+        // aunque el hijo termine antes de abrirlo
+        p->pidfd = pidfdOpen(pid);
+        if (p->pidfd == -1) {
+            perror("pidfd_open failed");
+            exit(EXIT_FAILURE);
+        }
+        tableInsert(pid, p);
+    } else {
+        // Ya existía: puede venir de otro slot, así que lo movemos de CPU
+        logMsg(LOG_DEBUG, "Resuming process: %s (PID: %d)\n", p->executableName, p->pid);
+        double start = nowSeconds();
+        if (pinToCpu(p->pid, s->cpu) == -1) {
+            perror("sched_setaffinity failed");
+        }
+        preemptBackend->resume(p);
+        switchStats.costUs += (nowSeconds() - start) * 1e6;
+    }
+    // Solo vigilamos los hijos en ejecución; los parados no pueden terminar
+    // y así no quedan eventos colgando de procesos que no están en un slot
+    watchFd(p->pidfd, EV_CHILD, p->pid);
+    startSlice(s, p);
+    armTimer(s, s->quantum);
+    switchStats.switches++;
+    return 0;
+}
+
+// Trabajos con at= que aún no han llegado, ordenados por su llegada
+Heap pendingArrivals;
+
+int arrivesBefore(Process *a, Process *b) {
+    if (a->arrivalMs != b->arrivalMs) {
+        return a->arrivalMs < b->arrivalMs;
+    }
+    return a->arrivalSec < b->arrivalSec;
+}
+
+// Programa arrivalFd para el instante absoluto dueSec (escala de nowSeconds,
+// que usa el mismo CLOCK_MONOTONIC que el timerfd)
+void armArrival(double dueSec) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = (time_t)dueSec;
+    its.it_value.tv_nsec = (long)((dueSec - (double)its.it_value.tv_sec) * 1e9);
+    timerfd_settime(arrivalFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// Trabajo que no se lanza porque falló una de sus dependencias
+void skipJob(Process *p) {
+    logMsg(LOG_INFO, "Skipping %s: a dependency failed\n", p->executableName);
+    dag.skipped++;
+    dag.nodes[p->dagNode].proc = POOL_NONE;
+    setStatus(p, EXITED);
+    freeProcess(p);
+}
+
+// Marca como fallidos todos los descendientes de node. Los retenidos se
+// descartan ya; los que aún no se han admitido, al admitirlos.
+void failDescendants(int node) {
+    int *stack = (int*)malloc(dag.count * sizeof(int));
+    if (!stack) {
+        perror("Failed to allocate memory for dependencies");
+        exit(EXIT_FAILURE);
+    }
+    int top = 0;
+    stack[top++] = node;
+    while (top > 0) {
+        DagNode *n = &dag.nodes[stack[--top]];
+        for (int i = 0; i < n->numChildren; i++) {
+            DagNode *c = &dag.nodes[n->children[i]];
+            if (c->state != DAG_PENDING) {
+                continue; // Ya visitado por otro padre fallido
+            }
+            c->state = DAG_FAILED;
+            if (c->held) {
+                c->held = 0;
+                skipJob(processAt(c->proc));
+            }
+            stack[top++] = (int)n->children[i];
+        }
+    }
+    free(stack);
+}
+
+// Primera entrada de p en la política, que puede rechazarlo (EDF). Un
+// rechazado no se lanza nunca, así que sus dependientes tampoco.
+void offerJob(Process *p) {
+    if (policy->admit && !policy->admit(p)) {
+        setStatus(p, EXITED);
+        if (p->dagNode >= 0) {
+            dag.nodes[p->dagNode].state = DAG_FAILED;
+            dag.nodes[p->dagNode].proc = POOL_NONE;
+            failDescendants(p->dagNode);
+        }
+        freeProcess(p);
+        return;
+    }
+    policy->push(p);
+}
+
+// p, con nodo en el grafo, acaba de terminar: avanza el camino crítico,
+// descuenta a sus dependientes y admite a los que ya no esperan a nadie
+void releaseDependents(Process *p, int code) {
+    int node = p->dagNode;
+    DagNode *n = &dag.nodes[node];
+    n->finishMs = n->startMs + (p->cpuUserUs + p->cpuSysUs) / 1000.0;
+    n->state = (code == 0) ? DAG_DONE : DAG_FAILED;
+    n->proc = POOL_NONE;
+    if (dag.critical < 0 || n->finishMs > dag.nodes[dag.critical].finishMs) {
+        dag.critical = node;
+    }
+    if (n->state == DAG_FAILED) {
+        failDescendants(node);
+        return;
+    }
+    double now = nowSeconds();
+    for (int i = 0; i < n->numChildren; i++) {
+        DagNode *c = &dag.nodes[n->children[i]];
+        if (c->state != DAG_PENDING) {
+            continue;
+        }
+        if (n->finishMs > c->startMs) {
+            c->startMs = n->finishMs;
+            c->critParent = node;
+        }
+        Process *child = processAt(c->proc);
+        if (--child->waitingOn == 0 && c->held) {
+            // Como con at=, las métricas cuentan desde que queda listo
+            c->held = 0;
+            gettimeofday(&child->entryTime, NULL);
+            child->arrivalSec = now;
+            child->readySec = now;
+            offerJob(child);
+        }
+    }
+}
+
+// Pasa p a la política salvo que aún espere a alguna dependencia: entonces
+// se queda retenido en su nodo hasta que releaseDependents lo suelte
+void admitJob(Process *p) {
+    if (p->status == EXITED) {
+        freeProcess(p); // Cancelado antes de llegar
+        return;
+    }
+    if (p->dagNode >= 0) {
+        DagNode *n = &dag.nodes[p->dagNode];
+        if (n->state == DAG_FAILED) {
+            skipJob(p);
+            return;
+        }
+        if (p->waitingOn > 0) {
+            n->held = 1;
+            return;
+        }
+    }
+    offerJob(p);
+}
+
+// Pasa a la política los trabajos que han llegado. Los que traen at= en el
+// futuro esperan en pendingArrivals hasta su hora; al entrar se les vuelve a
+// fijar la llegada para que las métricas cuenten desde at= y no desde la carga.
+void admitArrivals(Queue *arrivals) {
+    double now = nowSeconds();
+    while (!isQueueEmpty(arrivals)) {
+        Process *p = dequeue(arrivals);
+        if (startSec + p->arrivalMs / 1000.0 > now) {
+            heapPush(&pendingArrivals, p);
+        } else {
+            admitJob(p);
+        }
+    }
+    while (pendingArrivals.count > 0) {
+        Process *p = heapTop(&pendingArrivals);
+        double due = startSec + p->arrivalMs / 1000.0;
+        if (due > now) {
+            armArrival(due);
+            return;
+        }
+        heapPop(&pendingArrivals);
+        gettimeofday(&p->entryTime, NULL);
+        p->arrivalSec = now;
+        p->readySec = now;
+        admitJob(p);
+    }
+}
+
+// Métricas, política e historial de un trabajo terminado (real o simulado)
+void jobFinished(Process *p, int code) {
+    recordMetrics(p, code);
+    if (policy != NULL && policy->finished) {
+        policy->finished(p);
+    }
+    // Los que matamos al agotar el tope no dicen cuánto habrían durado
+    if (policy == NULL || policy->runLimitMs == 0 || p->remainingTime > 0) {
+        learnRuntime(p);
+    }
+    if (p->dagNode >= 0) {
+        releaseDependents(p, code);
+    }
+}
+
+// Da por terminado p, que ya se ha recogido: lo saca de su slot, de epoll y
+// de la tabla de finalización y muestra su informe
+void finishProcess(Process *p, int code) {
+    int inSlot = (p->slot >= 0);
+    if (inSlot) {
+        Slot *s = &slots[p->slot];
+        s->proc = NULL;
+        armTimer(s, 0);
+        unwatchFd(p->pidfd);
+        p->slot = -1;
+    }
+    tableRemove(p->pid);
+    close(p->pidfd);
+    finishOutput(p);
+    if (memoryControl()) {
+        memFinished(p);
+    }
+    if (preemptBackend->release) {
+        preemptBackend->release(p);
+    }
+    setStatus(p, EXITED);
+    printProcessReport(p, code);
+    jobFinished(p, code);
+    if (inSlot) {
+        freeProcess(p);
+    }
+    // Si no estaba en un slot sigue en la cola (parado y muerto desde fuera);
+    // fillSlots lo libera al sacarlo
+}
+
+// No se pudo crear el hijo de p: cuenta como terminado con 127 (lo que da
+// el shell si no encuentra la orden), así que queda en las métricas, la
+// política suelta lo que le tuviera reservado y sus dependientes fallan.
+// No se aprende su duración: no llegó a correr.
+void launchFailed(Process *p) {
+    if (preemptBackend->release) {
+        preemptBackend->release(p);
+    }
+    setStatus(p, EXITED);
+    printProcessReport(p, 127);
+    recordMetrics(p, 127);
+    if (policy->finished) {
+        policy->finished(p);
+    }
+    if (p->dagNode >= 0) {
+        releaseDependents(p, 127);
+    }
+    freeProcess(p);
+}
+
+// Rellena los slots libres con lo que diga la política
+void fillSlots(int verbose) {
+    for (int i = 0; i < numSlots; i++) {
+        if (slots[i].proc != NULL) {
+            continue;
+        }
+        // Los que esperaban memoria y ya caben van antes que la política
+        Process *p = memoryControl() ? memReady() : NULL;
+        if (p == NULL) {
+            if (policy->empty()) {
+                break;
+            }
+            p = policy->pop();
+            if (memoryControl() && !memoryAdmits(p)) {
+                memHold(p);
+                i--;
+                continue;
+            }
+        }
+        if (p->status == EXITED) {
+            // Murió mientras estaba parado en la cola y ya se recogió
+            freeProcess(p);
+            i--;
+            continue;
+        }
+        int isNew = (p->pid == -1);
+        if (dispatch(&slots[i], p) < 0) {
+            launchFailed(p);
+            i--; // Reintentamos el mismo slot con el siguiente
+            continue;
+        }
+        if (verbose && isNew) {
+            logMsg(LOG_INFO, "Started process: %s (PID: %d)\n", p->executableName, p->pid);
+        }
+    }
+}
+
+// Código de salida de un estado de wait4. Un hijo muerto por una señal da
+// 128 + señal, como en el shell: WEXITSTATUS daría 0 y pasaría por bueno
+// (sus dependientes after= se lanzarían igual)
+int exitCode(int status) {
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+}
+
+// Recoge pid si ya terminó y está pendiente en la tabla de finalización
+void completeChild(pid_t pid) {
+    Process *p = tableLookup(pid);
+    if (p == NULL) {
+        // Ya se recogió con otro aviso
+        return;
+    }
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, WNOHANG, &usage) > 0) {
+        recordUsage(p, &usage);
+        finishProcess(p, exitCode(status));
+    }
+}
+
+// Vacía el anillo de SIGCHLD. Como SIGCHLD no se encola, varias salidas
+// simultáneas pueden dejar un único registro, así que después barremos con
+// wait4(-1) para no perder ninguna.
+void drainChildRing() {
+    uint64_t count;
+    ssize_t r = read(sigEventFd, &count, sizeof(count));
+    (void)r;
+
+    unsigned tail = atomic_load_explicit(&childRingTail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&childRingHead, memory_order_acquire);
+    while (tail != head) {
+        ChildRecord rec = childRing[tail & (CHILD_RING_SIZE - 1)];
+        tail++;
+        atomic_store_explicit(&childRingTail, tail, memory_order_release);
+        completeChild(rec.pid);
+    }
+
+    int status;
+    struct rusage usage;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        Process *p = tableLookup(pid);
+        if (p != NULL) {
+            recordUsage(p, &usage);
+            finishProcess(p, exitCode(status));
+        }
+    }
+}
+
+// Si p ya terminó lo recoge y devuelve 1. Se comprueba justo antes de
+// pararlo, por si acabó en el último momento.
+int reapIfExited(Process *p) {
+    int status;
+    struct rusage usage;
+    if (wait4(p->pid, &status, WNOHANG, &usage) > 0) {
+        recordUsage(p, &usage);
+        finishProcess(p, exitCode(status));
+        return 1;
+    }
+    return 0;
+}
+
+// Para el proceso del slot s y descuenta usedMs de su tiempo total. Devuelve
+// el proceso si sigue vivo y hay que devolverlo a la política, o NULL si ya
+// terminó o se le mató por superar el tope.
+Process* stopRunning(Slot *s, int usedMs) {
+    Process *p = s->proc;
+    if (reapIfExited(p)) {
+        return NULL;
+    }
+
+    // Aún sigue corriendo, lo pausamos
+    logMsg(LOG_DEBUG, "Pausing process: %s (PID: %d)\n", p->executableName, p->pid);
+    preemptBackend->stop(p);
+    setStatus(p, STOPPED);
+    if (policy->charge) {
+        policy->charge(p);
+    }
+
+    p->remainingTime -= usedMs;
+    p->ranMs += usedMs;
+    if (policy->runLimitMs > 0 && p->remainingTime <= 0) {
+        // Se agotó su tiempo total, lo matamos y mostramos info. Sale con
+        // 137 (128 + SIGKILL), así que sus dependientes after= fallan
+        int status;
+        struct rusage usage;
+        kill(p->pid, SIGKILL);
+        wait4(p->pid, &status, 0, &usage);
+        recordUsage(p, &usage);
+        finishProcess(p, exitCode(status));
+        return NULL;
+    }
+
+    s->proc = NULL;
+    armTimer(s, 0);
+    p->slot = -1;
+    p->preemptions++;
+    p->readySec = nowSeconds();
+    unwatchFd(p->pidfd);
+    return p;
+}
+
+// Expulsa el proceso del slot s al agotar su quantum
+void preempt(Slot *s) {
+    double overshootUs = (nowSeconds() - s->sliceStartSec) * 1e6 - s->quantum * 1000.0;
+    switchStats.expirations++;
+    switchStats.overshootUs += overshootUs;
+    if (overshootUs > switchStats.maxOvershootUs) {
+        switchStats.maxOvershootUs = overshootUs;
+    }
+    double start = nowSeconds();
+    Process *p = stopRunning(s, s->quantum);
+    switchStats.costUs += (nowSeconds() - start) * 1e6;
+    if (p != NULL) {
+        if (policy->expired) {
+            policy->expired(p);
+        }
+        // Volvemos a encolarlo
+        policy->push(p);
+    }
+}
+
+// Si hay un proceso listo que según la política debe quitarle la CPU a uno
+// de los que corren, devuelve el slot del peor de ellos
+Slot* betterVictim() {
+    if (policy->better == NULL || policy->empty()) {
+        return NULL;
+    }
+    Process *next = policy->peek();
+    // Uno cancelado o muerto en la cola no expulsa a nadie: se descarta ya
+    while (next->status == EXITED) {
+        freeProcess(policy->pop());
+        if (policy->empty()) {
+            return NULL;
+        }
+        next = policy->peek();
+    }
+    Slot *victim = NULL;
+    for (int i = 0; i < numSlots; i++) {
+        Process *running = slots[i].proc;
+        if (running == NULL) {
+            return NULL; // Hay un slot libre: fillSlots se encarga
+        }
+        if (policy->better(next, running) &&
+            (victim == NULL || policy->better(victim->proc, running))) {
+            victim = &slots[i];
+        }
+    }
+    return victim;
+}
+
+// Expulsa al proceso que indique betterVictim y devuelve 1 si lo hubo
+int preemptForBetter() {
+    Slot *victim = betterVictim();
+    if (victim == NULL) {
+        return 0;
+    }
+    Process *p = stopRunning(victim, elapsedMs(victim->sliceStartSec));
+    if (p != NULL) {
+        policy->push(p);
+    }
+    return 1;
+}
+
+// Tras cada muestreo de memoria: si la residente no cabe y sigue creciendo,
+// para al de menor prioridad y mayor reserva de los que corren (parar no
+// libera memoria, solo frena el crecimiento, así que no se para a más
+// mientras no vuelva a crecer); cuando vuelve a haber sitio (o ya no corre
+// nadie) devuelve uno de los parados a la política
+void relieveMemoryPressure() {
+    long previousKb = memResidentKb;
+    memSample();
+    if (memResidentKb > memBudgetKb && memResidentKb > previousKb && runningCount() > 1) {
+        Slot *victim = NULL;
+        for (int i = 0; i < numSlots; i++) {
+            Process *p = slots[i].proc;
+            if (p == NULL) {
+                continue;
+            }
+            if (victim == NULL || p->priority > victim->proc->priority ||
+                (p->priority == victim->proc->priority && p->reservedKb > victim->proc->reservedKb)) {
+                victim = &slots[i];
+            }
+        }
+        Process *p = stopRunning(victim, elapsedMs(victim->sliceStartSec));
+        if (p != NULL) {
+            logMsg(LOG_INFO, "Memory pressure: %ld of %ld MB resident, stopping %s (PID: %d, %ld MB)\n",
+                   memResidentKb / 1024, memBudgetKb / 1024, p->executableName, p->pid,
+                   p->reservedKb / 1024);
+            enqueue(memParked, p);
+            memStops++;
+        }
+    } else if (!isQueueEmpty(memParked) &&
+               (memResidentKb <= memBudgetKb * MEM_RESUME || runningCount() == 0)) {
+        Process *p = dequeue(memParked);
+        logMsg(LOG_INFO, "Memory: %ld of %ld MB resident, %s back to the queue\n",
+               memResidentKb / 1024, memBudgetKb / 1024, p->executableName);
+        policy->push(p);
+    }
+}
+
+// ------------------ Control ------------------
+
+// Con -c RUTA el planificador atiende órdenes en un socket Unix, una por
+// línea. Cada respuesta son líneas de texto que acaban en "ok" o en
+// "error: motivo":
+//  status            trabajos por estado, slots ocupados y parámetros
+//  running           qué corre en cada slot
+//  jobs [DESDE]      trabajos vivos; si no caben todos, "next N" da el
+//                    DESDE con el que seguir
+//  metrics           terminados y medias de retorno, respuesta y espera
+//  set quantum MS    RR y PRIO; "set latency MS" en FAIR y "set boost MS"
+//                    en MLFQ. Vale desde el próximo despacho
+//  add LÍNEA         un trabajo, como si llegara por la entrada de trabajos
+//  cancel JOB        mata el trabajo o, si aún no se ha lanzado, lo descarta
+//  prio JOB N        cambia su prioridad (PRIO), como "!prio JOB N"
+// JOB es el número de trabajo (columna job de running y jobs, y lo que
+// contesta add), el mismo que usa la entrada de trabajos; vale también
+// para los que esperan en cola, retenidos por dependencias o por memoria.
+// Se atiende desde el bucle de eventos y ninguna orden cuesta más de unos pasos fijos: los
+// contadores se llevan al vuelo y jobs mira como mucho CONTROL_SCAN
+// registros. Se lee una vez por evento y se contesta sin bloquear; al
+// cliente que no lee sus respuestas se le cierra la conexión.
+#define EV_CONTROL_LISTEN 11 // Socket de escucha de control
+#define EV_CONTROL 12        // Conexión de control
+#define MAX_CONTROL_CLIENTS 16
+#define CONTROL_BUF_SIZE 1024
+#define CONTROL_REPLY_SIZE 16384
+#define CONTROL_MAX_ROWS 64
+#define CONTROL_SCAN 4096
+
+typedef struct ControlClient {
+    int fd;                    // -1 = libre
+    int len;                   // Bytes de una orden aún incompleta en buf
+    int discarding;            // La orden actual no cabe en buf: se descarta
+    char buf[CONTROL_BUF_SIZE];
+} ControlClient;
+
+ControlClient controlClients[MAX_CONTROL_CLIENTS];
+int controlFd = -1;          // Socket de escucha (-1 si no hay -c)
+const char *controlPath = NULL;
+long controlCancelled = 0;   // Trabajos cancelados por control
+
+const char *controlStatusNames[] = {"new", "running", "stopped", "blocked", "exited"};
+char controlReply[CONTROL_REPLY_SIZE];
+size_t controlReplyLen = 0;
+
+__attribute__((format(printf, 1, 2)))
+void reply(const char *fmt, ...) {
+    if (controlReplyLen >= CONTROL_REPLY_SIZE) {
+        return;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(controlReply + controlReplyLen, CONTROL_REPLY_SIZE - controlReplyLen, fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        controlReplyLen += (size_t)n;
+    }
+}
+
+void closeControlClient(ControlClient *c) {
+    unwatchFd(c->fd);
+    close(c->fd);
+    c->fd = -1;
+}
+
+// Trabajo vivo con ese número, o NULL
+Process* controlJob(const char *arg) {
+    char *end;
+    unsigned long job = strtoul(arg, &end, 10);
+    if (end == arg || job > UINT32_MAX) {
+        return NULL;
+    }
+    Process *p = findJob((unsigned)job);
+    // Uno muerto mientras estaba parado sigue en la cola hasta que se saca
+    return (p == NULL || p->status == EXITED) ? NULL : p;
+}
+
+// Parámetros de la política en curso, en la línea de status
+void replyPolicy() {
+    reply("policy %s", policy->name);
+    if (policy->quantum == rrQuantum) {
+        reply(" quantum_ms %d", rrQuantumMs);
+    } else if (policy == &prioPolicy) {
+        reply(" quantum_ms %d", prioQuantumMs);
+    } else if (policy == &fairPolicy) {
+        reply(" latency_ms %d", fairLatencyMs);
+    } else if (policy == &mlfqPolicy) {
+        reply(" boost_ms %d", mlfqPolicy.periodMs);
+    }
+    reply("\n");
+}
+
+void controlStatus() {
+    replyPolicy();
+    reply("slots %d running %d\n", numSlots, runningCount());
+    for (int s = NEW; s <= EXITED; s++) {
+        reply("%s %u\n", controlStatusNames[s], statusCounts[s]);
+    }
+    reply("pending %d\n", pendingArrivals.count);
+    if (memoryControl()) {
+        reply("memory_waiting %u memory_parked %u\n", memWaiting->count, memParked->count);
+    }
+    reply("finished %ld cancelled %ld seen %u\n", totals.finished, controlCancelled, jobsSeen);
+}
+
+void controlRunning() {
+    reply("slot job pid ran_ms quantum_ms name\n");
+    for (int i = 0; i < numSlots; i++) {
+        Process *p = slots[i].proc;
+        if (p != NULL) {
+            reply("%d %u %d %d %d %s\n", i, p->jobNo, p->pid,
+                  p->ranMs + elapsedMs(slots[i].sliceStartSec), slots[i].quantum,
+                  p->executableName);
+        }
+    }
+}
+
+void controlJobs(const char *arg) {
+    unsigned long from = strtoul(arg, NULL, 10);
+    if (from > pool.used) {
+        from = pool.used;
+    }
+    unsigned end = (pool.used - from > CONTROL_SCAN) ? from + CONTROL_SCAN : pool.used;
+    int rows = 0;
+    reply("job pid status slot priority waited_ms name\n");
+    unsigned id;
+    for (id = (unsigned)from; id < end && rows < CONTROL_MAX_ROWS; id++) {
+        Process *p = processAt(id);
+        if (p->status == EXITED) {
+            continue;
+        }
+        double waited = p->waitSec + (p->slot < 0 ? nowSeconds() - p->readySec : 0);
+        reply("%u %d %s %d %d %.0f %s\n", p->jobNo, p->pid, controlStatusNames[p->status],
+              p->slot, p->priority, waited * 1000, p->executableName);
+        rows++;
+    }
+    if (id < pool.used) {
+        reply("next %u\n", id);
+    }
+}
+
+void controlMetrics() {
+    long n = totals.finished;
+    reply("finished %ld failed %ld\n", n, totals.failed);
+    if (n > 0) {
+        reply("turnaround_mean %.6f response_mean %.6f waiting_mean %.6f preemptions %ld\n",
+              totals.turnaround / n, totals.response / n, totals.waiting / n, totals.preemptions);
+    }
+    reply("switches %ld expirations %ld uptime %.3f\n", switchStats.switches,
+          switchStats.expirations, nowSeconds() - startSec);
+}
+
+// Devuelve NULL si se aplicó o el motivo del error
+const char* controlSet(const char *name, int ms) {
+    if (ms <= 0) {
+        return "value must be positive";
+    }
+    if (strcmp(name, "quantum") == 0 && policy->quantum == rrQuantum) {
+        rrQuantumMs = ms;
+        if (numQuantumChanges > 0) {
+            // RR auto: parte de aquí, pero el siguiente reajuste puede cambiarlo
+            recordQuantum(nowSeconds() - startSec, ms);
+        }
+    } else if (strcmp(name, "quantum") == 0 && policy == &prioPolicy) {
+        prioQuantumMs = ms;
+    } else if (strcmp(name, "latency") == 0 && policy == &fairPolicy) {
+        fairLatencyMs = ms;
+    } else if (strcmp(name, "boost") == 0 && policy == &mlfqPolicy) {
+        mlfqPolicy.periodMs = ms;
+        startPeriodicTimer(ms);
+    } else {
+        return "no such parameter in this policy";
+    }
+    logMsg(LOG_INFO, "Control: %s set to %d ms\n", name, ms);
+    return NULL;
+}
+
+// A uno lanzado solo se le manda SIGKILL: lo recoge el camino de siempre
+// (pidfd si corre, SIGCHLD si estaba parado), que lo da por terminado con
+// 128 + SIGKILL y hace fallar a sus dependientes. Uno que aún no se ha
+// lanzado queda como EXITED y se libera al sacarlo de donde espere
+// (política, llegadas, memoria); sus dependientes fallan ya.
+void controlCancel(Process *p) {
+    controlCancelled++;
+    logMsg(LOG_INFO, "Control: cancelling %s (job %u)\n", p->executableName, p->jobNo);
+    if (p->pid != -1) {
+        kill(p->pid, SIGKILL);
+        return;
+    }
+    if (policy == &edfPolicy && p->deadlineSec != INFINITY) {
+        edfUtilization -= edfDensity(p);
+    }
+    setStatus(p, EXITED);
+    if (p->dagNode >= 0) {
+        DagNode *n = &dag.nodes[p->dagNode];
+        n->state = DAG_FAILED;
+        n->proc = POOL_NONE;
+        if (n->held) {
+            n->held = 0;
+            freeProcess(p);
+        }
+        failDescendants(p->dagNode);
+    }
+}
+
+void controlCommand(const char *line, Queue *arrivals) {
+    char name[16];
+    unsigned job;
+    int value;
+    Process *p;
+    const char *err = NULL;
+    if (strcmp(line, "status") == 0) {
+        controlStatus();
+    } else if (strcmp(line, "running") == 0) {
+        controlRunning();
+    } else if (strcmp(line, "jobs") == 0 || strncmp(line, "jobs ", 5) == 0) {
+        controlJobs(line + 4);
+    } else if (strcmp(line, "metrics") == 0) {
+        controlMetrics();
+    } else if (sscanf(line, "set %15s %d", name, &value) == 2) {
+        err = controlSet(name, value);
+    } else if (strncmp(line, "add ", 4) == 0) {
+        unsigned before = jobsSeen;
+        enqueueJob(arrivals, line + 4, strlen(line + 4));
+        if (jobsSeen == before) {
+            err = "empty job line";
+        } else {
+            reply("job %u\n", before);
+        }
+    } else if (strncmp(line, "cancel ", 7) == 0) {
+        if ((p = controlJob(line + 7)) == NULL) {
+            err = "no such job";
+        } else {
+            controlCancel(p);
+        }
+    } else if (sscanf(line, "prio %u %d", &job, &value) == 2) {
+        if (policy != &prioPolicy) {
+            err = "priorities only change under PRIO";
+        } else if ((p = changePriority(job, value)) == NULL) {
+            err = "no such job";
+        } else {
+            reply("priority %d\n", p->priority);
+        }
+    } else {
+        err = "unknown command";
+    }
+    if (err != NULL) {
+        reply("error: %s\n", err);
+    } else {
+        reply("ok\n");
+    }
+}
+
+// Una lectura por evento: lo que quede llega en el siguiente, porque epoll
+// avisa mientras haya datos. Así una conexión no acapara el bucle.
+void readControl(int i, Queue *arrivals) {
+    ControlClient *c = &controlClients[i];
+    ssize_t n = read(c->fd, c->buf + c->len, CONTROL_BUF_SIZE - c->len);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (n <= 0) {
+        closeControlClient(c);
+        return;
+    }
+
+    controlReplyLen = 0;
+    int end = c->len + (int)n;
+    int start = 0;
+    for (int k = c->len; k < end; k++) {
+        if (c->buf[k] != '\n') {
+            continue;
+        }
+        c->buf[k] = '\0';
+        if (k > start && c->buf[k - 1] == '\r') {
+            c->buf[k - 1] = '\0';
+        }
+        if (c->discarding) {
+            c->discarding = 0;
+            reply("error: command too long\n");
+        } else if (c->buf[start] != '\0') {
+            controlCommand(c->buf + start, arrivals);
+        }
+        start = k + 1;
+    }
+    c->len = end - start;
+    memmove(c->buf, c->buf + start, c->len);
+    if (c->len == CONTROL_BUF_SIZE) {
+        c->len = 0;
+        c->discarding = 1;
+    }
+
+    if (controlReplyLen > 0) {
+        if (controlReplyLen >= CONTROL_REPLY_SIZE) {
+            closeControlClient(c); // Demasiadas órdenes de golpe
+            return;
+        }
+        ssize_t sent = send(c->fd, controlReply, controlReplyLen, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent != (ssize_t)controlReplyLen) {
+            closeControlClient(c);
+        }
+    }
+}
+
+void acceptControl() {
+    while (1) {
+        int fd = accept4(controlFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EINTR) {
+                perror("accept failed");
+            }
+            return;
+        }
+        int i = 0;
+        while (i < MAX_CONTROL_CLIENTS && controlClients[i].fd != -1) {
+            i++;
+        }
+        if (i == MAX_CONTROL_CLIENTS) {
+            logMsg(LOG_ERROR, "Too many control connections, closing the new one\n");
+            close(fd);
+            continue;
+        }
+        controlClients[i].fd = fd;
+        controlClients[i].len = 0;
+        controlClients[i].discarding = 0;
+        watchFd(fd, EV_CONTROL, i);
+    }
+}
+
+void openControl(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    controlFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (controlFd == -1 ||
+        bind(controlFd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+        listen(controlFd, MAX_CONTROL_CLIENTS) == -1) {
+        perror("Failed to open control socket");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < MAX_CONTROL_CLIENTS; i++) {
+        controlClients[i].fd = -1;
+    }
+    watchFd(controlFd, EV_CONTROL_LISTEN, 0);
+    logMsg(LOG_INFO, "Control socket on %s\n", path);
+}
+
+void closeControl(const char *path) {
+    for (int i = 0; i < MAX_CONTROL_CLIENTS; i++) {
+        if (controlClients[i].fd != -1) {
+            closeControlClient(&controlClients[i]);
+        }
+    }
+    close(controlFd);
+    unlink(path);
+    controlFd = -1;
+}
+
+// ------------------ Entrada continua de trabajos ------------------
+
+// Además de un fichero normal, los trabajos pueden llegar mientras el
+// planificador está corriendo:
+//  - "-": por stdin, hasta EOF
+//  - un FIFO: se abre en lectura/escritura para que no dé EOF cuando se van
+//    los escritores, así el planificador sigue sirviendo indefinidamente
+//  - "unix:RUTA": socket Unix de escucha; cada conexión envía líneas
+// Se lee sin bloquear desde el bucle de eventos y cada línea completa se
+// encola con su hora real de llegada. Las líneas que empiezan por '!' son
+// órdenes, no trabajos:
+//  !prio JOB N    cambia la prioridad del trabajo número JOB (PRIO): el
+//                 orden de llegada desde 0, como en la traza; vale aunque
+//                 aún no se haya lanzado
+#define INTAKE_BUF_SIZE 4096
+#define MAX_INTAKE_SOURCES 64
+
+typedef struct IntakeSource {
+    int fd;                    // -1 = libre
+    int len;                   // Bytes de una línea aún incompleta en buf
+    int discarding;            // La línea actual no cabe en buf: se descarta
+    char buf[INTAKE_BUF_SIZE];
+} IntakeSource;
+
+IntakeSource intakeSources[MAX_INTAKE_SOURCES];
+int numIntakeSources = 0; // Fuentes abiertas ahora mismo
+int listenFd = -1;        // Socket de escucha (-1 si no hay)
+
+// ¿Pueden llegar todavía trabajos nuevos?
+int intakeOpen() {
+    return listenFd >= 0 || numIntakeSources > 0;
+}
+
+int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return (flags == -1) ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void addIntakeSource(int fd) {
+    for (int i = 0; i < MAX_INTAKE_SOURCES; i++) {
+        if (intakeSources[i].fd == -1) {
+            intakeSources[i].fd = fd;
+            intakeSources[i].len = 0;
+            intakeSources[i].discarding = 0;
+            numIntakeSources++;
+            setNonBlocking(fd);
+            watchFd(fd, EV_INTAKE, i);
+            return;
+        }
+    }
+    fprintf(stderr, "Too many job sources, closing the new one\n");
+    close(fd);
+}
+
+void closeIntakeSource(IntakeSource *src) {
+    unwatchFd(src->fd);
+    if (src->fd != STDIN_FILENO) {
+        close(src->fd);
+    }
+    src->fd = -1;
+    numIntakeSources--;
+}
+
+// Orden de una línea que empieza por '!' (ver arriba)
+void intakeCommand(const char *line) {
+    unsigned job;
+    int priority;
+    if (sscanf(line, "!prio %u %d", &job, &priority) == 2) {
+        changePriority(job, priority);
+        return;
+    }
+    logMsg(LOG_ERROR, "Unknown command: %s\n", line);
+}
+
+// Una línea completa (terminada en '\0') de la entrada continua
+void intakeLine(Queue *q, const char *line, size_t len) {
+    if (line[0] == '!') {
+        intakeCommand(line);
+    } else {
+        enqueueJob(q, line, len);
+    }
+}
+
+// Lee todo lo disponible en la fuente i y encola cada línea completa
+void readIntake(int i, Queue *q) {
+    IntakeSource *src = &intakeSources[i];
+    while (1) {
+        // Siempre queda sitio para el '\0' y se pide al menos un byte, así
+        // que n == 0 solo puede ser EOF
+        ssize_t n = read(src->fd, src->buf + src->len, INTAKE_BUF_SIZE - 1 - src->len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                perror("Failed to read jobs");
+                closeIntakeSource(src);
+            }
+            return;
+        }
+        if (n == 0) {
+            // EOF: una última línea sin salto también cuenta
+            if (src->len > 0 && !src->discarding) {
+                src->buf[src->len] = '\0';
+                intakeLine(q, src->buf, src->len);
+            }
+            closeIntakeSource(src);
+            return;
+        }
+
+        int end = src->len + (int)n;
+        int start = 0;
+        for (int k = src->len; k < end; k++) {
+            if (src->buf[k] != '\n') {
+                continue;
+            }
+            src->buf[k] = '\0';
+            if (src->discarding) {
+                src->discarding = 0;
+            } else if (k > start) {
+                intakeLine(q, src->buf + start, k - start);
+            }
+            start = k + 1;
+        }
+        // Movemos la línea incompleta al principio del buffer
+        src->len = end - start;
+        memmove(src->buf, src->buf + start, src->len);
+        if (src->len >= INTAKE_BUF_SIZE - 1) {
+            if (!src->discarding) {
+                fprintf(stderr, "Job line too long, discarding it\n");
+            }
+            src->len = 0;
+            src->discarding = 1;
+        }
+    }
+}
+
+void acceptIntake() {
+    while (1) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EINTR) {
+                perror("accept failed");
+            }
+            return;
+        }
+        addIntakeSource(fd);
+    }
+}
+
+// Prepara la entrada de trabajos indicada en la línea de comandos. Devuelve
+// 1 si es continua (stdin, FIFO o socket) y 0 si es un fichero normal, que
+// se carga entero con loadProcessesFromFile como siempre.
+int openIntake(const char *spec) {
+    for (int i = 0; i < MAX_INTAKE_SOURCES; i++) {
+        intakeSources[i].fd = -1;
+    }
+    int streaming = 1;
+
+    if (strncmp(spec, "unix:", 5) == 0) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(spec + 5) >= sizeof(addr.sun_path)) {
+            fprintf(stderr, "Socket path too long: %s\n", spec + 5);
+            exit(EXIT_FAILURE);
+        }
+        strcpy(addr.sun_path, spec + 5);
+        unlink(addr.sun_path);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd == -1 ||
+            bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+            listen(listenFd, 16) == -1) {
+            perror("Failed to open job socket");
+            exit(EXIT_FAILURE);
+        }
+        watchFd(listenFd, EV_LISTEN, 0);
+        logMsg(LOG_INFO, "Listening for jobs on %s\n", addr.sun_path);
+    } else {
+        struct stat st;
+        if (strcmp(spec, "-") == 0) {
+            // epoll no admite ficheros normales: "< fichero" se carga de golpe
+            if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode)) {
+                streaming = 0;
+            } else {
+                addIntakeSource(STDIN_FILENO);
+            }
+        } else if (stat(spec, &st) == 0 && S_ISFIFO(st.st_mode)) {
+            int fd = open(spec, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            if (fd == -1) {
+                perror("Failed to open FIFO");
+                exit(EXIT_FAILURE);
+            }
+            addIntakeSource(fd);
+        } else {
+            streaming = 0;
+        }
+    }
+
+    if (streaming) {
+        // Un planificador de larga duración debe dejar ver su salida al
+        // momento aunque stdout sea un fichero
+        setvbuf(stdout, NULL, _IOLBF, 0);
+    }
+    return streaming;
+}
+
+void closeIntake(const char *spec) {
+    for (int i = 0; i < MAX_INTAKE_SOURCES; i++) {
+        if (intakeSources[i].fd != -1) {
+            closeIntakeSource(&intakeSources[i]);
+        }
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(spec + 5);
+        listenFd = -1;
+    }
+}
+
+// Bucle común: duerme en epoll_wait hasta que termina un hijo (pidfd),
+// vence el quantum de algún slot (timerfd) o llegan trabajos nuevos. Un
+// quantum 0 no arma ningún timer y el proceso corre hasta el final.
+// Mientras la entrada continua siga abierta no se sale aunque no quede nada.
+void runEventLoop(Queue *arrivals, int verbose) {
+    struct epoll_event events[MAX_EVENTS];
+
+    startPeriodicTimer(policy->periodMs);
+    admitArrivals(arrivals);
+    fillSlots(verbose);
+    while (!policy->empty() || runningCount() > 0 || pendingArrivals.count > 0 || intakeOpen() ||
+           (memoryControl() && (!isQueueEmpty(memWaiting) || !isQueueEmpty(memParked)))) {
+        logFlush();
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait failed");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < n; i++) {
+            int type = (int)(events[i].data.u64 >> 32);
+            int id = (int)(uint32_t)events[i].data.u64;
+
+            if (type == EV_TIMER) {
+                uint64_t expirations;
+                // Si el slot cambió de proceso en esta tanda, el timer se
+                // rearmó y no queda nada que leer
+                if (read(slots[id].timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                    continue;
+                }
+                if (slots[id].proc != NULL) {
+                    preempt(&slots[id]);
+                }
+            } else if (type == EV_CHILD) {
+                completeChild(id);
+            } else if (type == EV_SIGNAL) {
+                drainChildRing();
+            } else if (type == EV_INTAKE) {
+                readIntake(id, arrivals);
+            } else if (type == EV_LISTEN) {
+                acceptIntake();
+            } else if (type == EV_CONTROL) {
+                readControl(id, arrivals);
+            } else if (type == EV_CONTROL_LISTEN) {
+                acceptControl();
+            } else if (type == EV_PERIODIC) {
+                uint64_t expirations;
+                if (read(periodicFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    policy->periodic();
+                }
+            } else if (type == EV_STDOUT || type == EV_STDERR) {
+                drainOutput(processAt((unsigned)id), type - EV_STDOUT);
+            } else if (type == EV_MEMORY) {
+                uint64_t expirations;
+                if (read(memTimerFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    relieveMemoryPressure();
+                }
+            } else if (type == EV_ARRIVAL) {
+                // admitArrivals, tras la tanda, da paso a los que ya tocan
+                uint64_t expirations;
+                if (read(arrivalFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                    continue;
+                }
+            }
+        }
+
+        admitArrivals(arrivals);
+        fillSlots(verbose);
+        while (preemptForBetter()) {
+            fillSlots(verbose);
+        }
+    }
+    startPeriodicTimer(0);
+}
+
+// ------------------ Simulación ------------------
+
+// --simulate: las mismas políticas sobre el reloj virtual, sin lanzar nada.
+// Cada línea de la traza es un trabajo con su llegada (at=) y sus ráfagas
+// (bursts=CPU,E/S,CPU,...); sin bursts= corre de un tirón lo que prediga el
+// historial. La traza se lee según llegan los trabajos, así que la memoria
+// depende de los trabajos vivos y no de su longitud; las líneas deben venir
+// ordenadas por llegada. Lo pendiente espera en un calendario de sucesos
+// (montículo binario por tiempo).
+typedef enum {
+    SIM_ARRIVAL,  // Llega el siguiente trabajo de la traza
+    SIM_SLICE,    // El slot id acaba ráfaga o quantum (si gen sigue vigente)
+    SIM_IO_DONE,  // El proceso id termina su E/S
+    SIM_PERIODIC  // Timer periódico de la política
+} SimEventType;
+
+typedef struct SimEvent {
+    double time;
+    unsigned seq; // A igual tiempo, por orden de creación
+    SimEventType type;
+    unsigned id;
+    unsigned gen;
+} SimEvent;
+
+typedef struct SimCalendar {
+    SimEvent *events;
+    unsigned capacity;
+    unsigned count;
+    unsigned seq;
+} SimCalendar;
+
+SimCalendar calendar = {NULL, 0, 0, 0};
+
+JobReader simTrace;
+Process *simPending = NULL; // Siguiente trabajo de la traza, ya leído
+int simLaunches = 0;        // Hace de PID de los trabajos simulados
+int simBlocked = 0;         // Trabajos en E/S
+int simDone = 0;
+double simTurnaround = 0, simResponse = 0, simWaiting = 0;
+
+static inline int simBefore(SimEvent *a, SimEvent *b) {
+    return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+void simSchedule(double time, SimEventType type, unsigned id, unsigned gen) {
+    if (calendar.count == calendar.capacity) {
+        calendar.capacity = calendar.capacity ? calendar.capacity * 2 : 64;
+        SimEvent *events = (SimEvent*)realloc(calendar.events, calendar.capacity * sizeof(SimEvent));
+        if (!events) {
+            perror("Failed to allocate memory for event calendar");
+            exit(EXIT_FAILURE);
+        }
+        calendar.events = events;
+    }
+    SimEvent ev = {time, calendar.seq++, type, id, gen};
+    unsigned i = calendar.count++;
+    while (i > 0 && simBefore(&ev, &calendar.events[(i - 1) / 2])) {
+        calendar.events[i] = calendar.events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    calendar.events[i] = ev;
+}
+
+SimEvent simNextEvent() {
+    SimEvent top = calendar.events[0];
+    SimEvent last = calendar.events[--calendar.count];
+    unsigned i = 0;
+    for (;;) {
+        unsigned c = 2 * i + 1;
+        if (c >= calendar.count) {
+            break;
+        }
+        if (c + 1 < calendar.count && simBefore(&calendar.events[c + 1], &calendar.events[c])) {
+            c++;
+        }
+        if (!simBefore(&calendar.events[c], &last)) {
+            break;
+        }
+        calendar.events[i] = calendar.events[c];
+        i = c;
+    }
+    calendar.events[i] = last;
+    return top;
+}
+
+// Lee el siguiente trabajo de la traza y planifica su llegada
+void simReadNext() {
+    const char *line;
+    size_t len;
+    simPending = NULL;
+    while (nextJobLine(&simTrace, &line, &len)) {
+        if (!isJobLine(line, len)) {
+            continue;
+        }
+        Process *p = allocProcess();
+        initJob(p, line, len);
+        if (p->numBursts == 0) {
+            static const char zero[] = "0";
+            parseBursts(p, zero, zero + 1);
+            p->bursts[0] = (int)p->predictedMs;
+        }
+        p->burstLeftMs = p->bursts[0];
+        double at = p->arrivalMs / 1000.0;
+        simSchedule(at > simNow ? at : simNow, SIM_ARRIVAL, p->id, 0);
+        simPending = p;
+        return;
+    }
+}
+
+void simDispatch(Slot *s, Process *p) {
+    if (p->pid == -1) {
+        if (p->remainingTime <= 0) {
+            p->remainingTime = policy->runLimitMs;
+        }
+        p->pid = ++simLaunches;
+    }
+    startSlice(s, p);
+    double ms = p->burstLeftMs;
+    if (s->quantum > 0 && s->quantum < ms) {
+        ms = s->quantum;
+    }
+    simSchedule(simNow + ms / 1000, SIM_SLICE, (unsigned)(s - slots), ++s->gen);
+}
+
+void simFillSlots() {
+    for (int i = 0; i < numSlots && !policy->empty(); i++) {
+        if (slots[i].proc == NULL) {
+            simDispatch(&slots[i], policy->pop());
+        }
+    }
+}
+
+// Cobra a p, que deja el slot s, la CPU de este quantum
+void simLeaveSlot(Slot *s, Process *p, double usedMs) {
+    p->burstLeftMs -= usedMs;
+    p->simCpuMs += usedMs;
+    s->proc = NULL;
+    s->gen++;
+    p->slot = -1;
+    if (policy->charge) {
+        policy->charge(p);
+    }
+}
+
+void simFinish(Process *p, int code) {
+    setStatus(p, EXITED);
+    p->cpuUserUs = (long)(p->simCpuMs * 1000);
+    jobFinished(p, code);
+    simDone++;
+    simTurnaround += simNow - p->arrivalSec;
+    simResponse += p->firstRunSec - p->arrivalSec;
+    simWaiting += p->waitSec;
+    freeProcess(p);
+}
+
+// Equivalente a stopRunning: devuelve p si hay que devolverlo a la política
+Process* simStop(Slot *s) {
+    Process *p = s->proc;
+    double usedMs = (simNow - s->sliceStartSec) * 1000;
+    simLeaveSlot(s, p, usedMs);
+    setStatus(p, STOPPED);
+    p->remainingTime -= (int)usedMs;
+    p->ranMs += (int)usedMs;
+    if (policy->runLimitMs > 0 && p->remainingTime <= 0) {
+        simFinish(p, 128 + SIGKILL); // Como en stopRunning
+        return NULL;
+    }
+    p->preemptions++;
+    p->readySec = simNow;
+    return p;
+}
+
+// Fin de quantum o de ráfaga de CPU en el slot s
+void simSliceEnd(Slot *s) {
+    Process *p = s->proc;
+    double usedMs = (simNow - s->sliceStartSec) * 1000;
+    if (p->burstLeftMs - usedMs > 1e-6) {
+        Process *stopped = simStop(s);
+        if (stopped != NULL) {
+            if (policy->expired) {
+                policy->expired(stopped);
+            }
+            policy->push(stopped);
+        }
+        return;
+    }
+
+    simLeaveSlot(s, p, p->burstLeftMs);
+    p->ranMs += (int)usedMs;
+    p->burst++;
+    if (p->burst >= p->numBursts) {
+        simFinish(p, 0);
+        return;
+    }
+    // Sigue una ráfaga de E/S
+    int ioMs = p->bursts[p->burst++];
+    p->burstLeftMs = (p->burst < p->numBursts) ? p->bursts[p->burst] : 0;
+    setStatus(p, BLOCKED);
+    simBlocked++;
+    simSchedule(simNow + ioMs / 1000.0, SIM_IO_DONE, p->id, 0);
+}
+
+void simIoDone(Process *p) {
+    simBlocked--;
+    if (p->burst >= p->numBursts) {
+        simFinish(p, 0); // Acababa en E/S
+        return;
+    }
+    setStatus(p, STOPPED);
+    p->readySec = simNow;
+    policy->push(p);
+}
+
+void simulate() {
+    double wallStart = clock() / (double)CLOCKS_PER_SEC;
+
+    simNow = 0;
+    simReadNext();
+    if (policy->periodMs > 0) {
+        simSchedule(policy->periodMs / 1000.0, SIM_PERIODIC, 0, 0);
+    }
+    while (calendar.count > 0) {
+        SimEvent ev = simNextEvent();
+        if (ev.type == SIM_SLICE && ev.gen != slots[ev.id].gen) {
+            continue; // El slot cambió de proceso antes de que venciera
+        }
+        simNow = ev.time;
+
+        if (ev.type == SIM_ARRIVAL) {
+            Process *p = simPending;
+            p->arrivalSec = simNow;
+            p->readySec = simNow;
+            admitJob(p);
+            simReadNext();
+        } else if (ev.type == SIM_SLICE) {
+            simSliceEnd(&slots[ev.id]);
+        } else if (ev.type == SIM_IO_DONE) {
+            simIoDone(processAt(ev.id));
+        } else if (ev.type == SIM_PERIODIC) {
+            policy->periodic();
+            if (simPending != NULL || !policy->empty() || runningCount() > 0 || simBlocked > 0) {
+                simSchedule(simNow + policy->periodMs / 1000.0, SIM_PERIODIC, 0, 0);
+            }
+        }
+
+        simFillSlots();
+        Slot *victim;
+        while ((victim = betterVictim()) != NULL) {
+            Process *p = simStop(victim);
+            if (p != NULL) {
+                policy->push(p);
+            }
+            simFillSlots();
+        }
+    }
+
+    double wall = clock() / (double)CLOCKS_PER_SEC - wallStart;
+    logMsg(LOG_INFO, "Simulated %d jobs in %.2f s of CPU: makespan %.3f s\n", simDone, wall, simNow);
+    if (simDone > 0) {
+        logMsg(LOG_INFO, "Mean turnaround %.6f s, response %.6f s, waiting %.6f s\n",
+               simTurnaround / simDone, simResponse / simDone, simWaiting / simDone);
+    }
+    free(calendar.events);
+}
+
+// Con --simulate la política corre sobre la traza en vez de sobre la cola
+void runPolicy(Queue *q, int verbose) {
+    if (simulating) {
+        simulate();
+    } else {
+        runEventLoop(q, verbose);
+    }
+}
+
+// ------------------ FCFS ------------------
+
+// Cada slot ejecuta su proceso hasta el final y coge el siguiente de la cola
+void firstComeFirstServe(Queue* processes) {
+    policy = &fcfsPolicy;
+    runPolicy(processes, 0);
+}
+
+// ------------------ Round Robin ------------------
+
+// Cada slot aplica RR de forma independiente sobre la cola compartida
+void roundRobin(Queue* q, int quantum) {
+    rrQuantumMs = quantum;
+    policy = &rrPolicy;
+    runPolicy(q, 1);
+}
+
+// RR auto: cada ADAPT_PERIOD_MS se reajusta el quantum para que
+// ADAPT_PERCENTILE de las ráfagas recientes quepan en uno solo, pero sin
+// bajar de lo que hace falta para que parar, reanudar y el retraso del timer
+// no se coman más de ADAPT_MAX_OVERHEAD del tiempo de CPU
+#define ADAPT_PERIOD_MS 500
+#define ADAPT_SAMPLES 64           // Ráfagas recientes que se tienen en cuenta
+#define ADAPT_PERCENTILE 0.80
+#define ADAPT_MAX_OVERHEAD 0.01
+#define ADAPT_INITIAL_MS 100       // Hasta que termine algún trabajo
+#define ADAPT_MIN_MS 1
+#define ADAPT_MAX_MS 1000
+
+double adaptBursts[ADAPT_SAMPLES]; // Anillo con la CPU total de cada trabajo
+int adaptSeen = 0;
+
+// Con un solo periodo de CPU por trabajo, su ráfaga es toda la CPU que gastó
+void rrAdaptFinished(Process *p) {
+    adaptBursts[adaptSeen++ % ADAPT_SAMPLES] = (p->cpuUserUs + p->cpuSysUs) / 1000.0;
+}
+
+void rrRetune() {
+    int n = adaptSeen < ADAPT_SAMPLES ? adaptSeen : ADAPT_SAMPLES;
+    int q = rrQuantumMs;
+    double burstMs = 0, costUs = 0;
+    if (n > 0) {
+        double sorted[ADAPT_SAMPLES];
+        memcpy(sorted, adaptBursts, n * sizeof(double));
+        qsort(sorted, n, sizeof(double), compareDoubles);
+        burstMs = percentile(sorted, n, ADAPT_PERCENTILE);
+        q = (int)ceil(burstMs);
+    }
+    // Coste de cada expiración: parar al que sale, reanudar al siguiente y lo
+    // que se pasó el timer. Con sobrecarga f hace falta quantum >= c (1 - f) / f
+    if (switchStats.expirations > 0) {
+        costUs = (switchStats.overshootUs + switchStats.costUs) / switchStats.expirations;
+        int minQ = (int)ceil(costUs * (1 - ADAPT_MAX_OVERHEAD) / ADAPT_MAX_OVERHEAD / 1000.0);
+        if (q < minQ) {
+            q = minQ;
+        }
+    }
+    if (q < ADAPT_MIN_MS) {
+        q = ADAPT_MIN_MS;
+    } else if (q > ADAPT_MAX_MS) {
+        q = ADAPT_MAX_MS;
+    }
+    // Cambios de menos del 10% no compensan el ruido en el historial
+    if (abs(q - rrQuantumMs) * 10 > rrQuantumMs) {
+        rrQuantumMs = q;
+        recordQuantum(nowSeconds() - startSec, q);
+        logMsg(LOG_INFO, "Adaptive quantum: %d ms (p%d burst %.1f ms, switch cost %.1f us)\n",
+               q, (int)(ADAPT_PERCENTILE * 100), burstMs, costUs);
+    }
+}
+
+void rrAdaptReport() {
+    logMsg(LOG_INFO, "Adaptive quantum: %d ms after %d changes\n",
+           rrQuantumMs, numQuantumChanges - 1);
+}
+
+Policy rrAdaptivePolicy = {
+    .name = "RR auto", .push = fifoPush, .pop = fifoPop, .peek = fifoPeek,
+    .empty = fifoEmpty, .quantum = rrQuantum,
+    .periodMs = ADAPT_PERIOD_MS, .periodic = rrRetune,
+    .finished = rrAdaptFinished, .report = rrAdaptReport,
+    .runLimitMs = 5000, // El mismo tope que RR
+};
+
+void roundRobinAdaptive(Queue* q) {
+    rrQuantumMs = ADAPT_INITIAL_MS;
+    recordQuantum(0, rrQuantumMs);
+    policy = &rrAdaptivePolicy;
+    runPolicy(q, 1);
+}
+
+// ------------------ MLFQ ------------------
+
+// Requiere initMlfq con los quanta por nivel y el periodo de subida
+void multiLevelFeedbackQueue(Queue* q) {
+    policy = &mlfqPolicy;
+    runPolicy(q, 1);
+}
+
+// ------------------ SJF / SRTF ------------------
+
+// Ordena por la duración predicha; con preemptive (SRTF) expulsa al que
+// esté corriendo si llega uno al que le queda menos
+void shortestJobFirst(Queue* q, int preemptive) {
+    policy = preemptive ? &srtfPolicy : &sjfPolicy;
+    heapInit(&sjfHeap, preemptive ? srtfLess : sjfLess);
+    runPolicy(q, preemptive);
+}
+
+// ------------------ FAIR ------------------
+
+// Reparte la CPU por peso (nice) ordenando por vruntime; latencyMs es el
+// periodo en el que todos los listos deberían haber corrido una vez
+void fairScheduler(Queue* q, int latencyMs) {
+    fairLatencyMs = latencyMs;
+    policy = &fairPolicy;
+    runPolicy(q, 1);
+}
+
+// ------------------ PRIO ------------------
+
+// Prioridades estáticas (prio=) con envejecimiento; quantum para los de la
+// misma prioridad
+void priorityScheduler(Queue* q, int quantum) {
+    prioQuantumMs = quantum;
+    initPrio();
+    policy = &prioPolicy;
+    runPolicy(q, 1);
+}
+
+// ------------------ EDF ------------------
+
+// Plazos (deadline=) con expulsión y prueba de utilización al llegar
+void earliestDeadlineFirst(Queue* q) {
+    policy = &edfPolicy;
+    heapInit(&edfHeap, edfLess);
+    runPolicy(q, 1);
+}
+
+// ------------------ main ------------------
+
+#ifndef SCHEDULER_NO_MAIN
+void usage(const char *prog) {
+    printf("Usage: %s [-j N] [-l fork|spawn] [-m file] [-H file] [-T trace.json] [-L error|info|debug] [-o dir] [-C bytes] [-P signal|cgroup] [-M MB] [-c socket] [--simulate] <policy> [args] <filename>\n", prog);
+    printf("  FCFS <filename>\n");
+    printf("  RR <quantum|auto> <filename>\n");
+    printf("  MLFQ <q0,q1,...> <boost_ms> <filename>\n");
+    printf("  SJF <filename>\n");
+    printf("  SRTF <filename>\n");
+    printf("  FAIR <latency_ms> <filename>\n");
+    printf("  PRIO <quantum> <filename>\n");
+    printf("  EDF <filename>\n");
+}
+
+int main(int argc, char **argv) {
+    char *prog = argv[0];
+
+    // Opciones:
+    //  -j N             número de slots que ejecutan procesos a la vez
+    //  -l fork|spawn    backend de lanzamiento (por defecto spawn)
+    //  -m FICHERO       métricas por trabajo al terminar (.json o CSV)
+    //  -H FICHERO       historial de duraciones de SJF/SRTF/EDF (por defecto
+    //                   scheduler.history)
+    //  -T FICHERO       traza de cambios de estado en JSON de Chrome/Perfetto
+    //  -o DIR           salida de cada trabajo en DIR/<n>-<nombre>.out y .err
+    //  -C BYTES         guarda los primeros BYTES de stdout de cada trabajo
+    //                   en las métricas JSON (-m)
+    //  -P signal|cgroup cómo se expulsa: SIGSTOP/SIGCONT (por defecto) o
+    //                   congelando la hoja de cgroup v2 de cada trabajo
+    //  -M MB            presupuesto de memoria: no se lanzan trabajos cuyo pico
+    //                   (mem= o aprendido) no quepa y se para alguno si la
+    //                   residente lo supera
+    //  -c RUTA          socket Unix de control: consultas y cambios en caliente
+    //                   (se ignora en --simulate)
+    //  -L NIVEL         error, info o debug (por defecto; incluye los mensajes
+    //                   de cada quantum)
+    //  --simulate       no lanza nada: <filename> es una traza (at=, bursts=)
+    //                   que se simula con reloj virtual
+    // <filename> también puede ser "-" (stdin), un FIFO o "unix:RUTA" para
+    // recibir trabajos mientras el planificador está corriendo
+    int jobs = 1;
+    int pin = 0;
+    int opt;
+    const char *historyFile = "scheduler.history";
+    const char *tracePath = NULL;
+    static struct option longOptions[] = {
+        {"simulate", no_argument, NULL, 'S'},
+        {NULL, 0, NULL, 0}
+    };
+    while ((opt = getopt_long(argc, argv, "+j:l:m:H:T:L:o:C:P:M:c:", longOptions, NULL)) != -1) {
+        if (opt == 'j') {
+            jobs = atoi(optarg);
+            pin = 1;
+            if (jobs <= 0) {
+                printf("Invalid -j value. Must be positive.\n");
+                return 1;
+            }
+        } else if (opt == 'm') {
+            metricsPath = optarg;
+        } else if (opt == 'H') {
+            historyFile = optarg;
+        } else if (opt == 'T') {
+            tracePath = optarg;
+        } else if (opt == 'P' && strcmp(optarg, "signal") == 0) {
+            preemptBackend = &signalBackend;
+        } else if (opt == 'P' && strcmp(optarg, "cgroup") == 0) {
+            preemptBackend = &cgroupBackend;
+        } else if (opt == 'M') {
+            memBudgetKb = atol(optarg) * 1024;
+            if (memBudgetKb <= 0) {
+                printf("Invalid -M value. Must be positive (MB).\n");
+                return 1;
+            }
+        } else if (opt == 'c') {
+            controlPath = optarg;
+        } else if (opt == 'o') {
+            outputDir = optarg;
+        } else if (opt == 'C') {
+            long bytes = atol(optarg);
+            if (bytes <= 0) {
+                printf("Invalid -C value. Must be positive.\n");
+                return 1;
+            }
+            captureLimit = (size_t)bytes;
+        } else if (opt == 'L' && strcmp(optarg, "error") == 0) {
+            logLevel = LOG_ERROR;
+        } else if (opt == 'L' && strcmp(optarg, "info") == 0) {
+            logLevel = LOG_INFO;
+        } else if (opt == 'L' && strcmp(optarg, "debug") == 0) {
+            logLevel = LOG_DEBUG;
+        } else if (opt == 'S') {
+            simulating = 1;
+        } else if (opt == 'l' && strcmp(optarg, "fork") == 0) {
+            launchBackend = LAUNCH_FORK;
+        } else if (opt == 'l' && strcmp(optarg, "spawn") == 0) {
+            launchBackend = LAUNCH_SPAWN;
+        } else {
+            usage(prog);
+            return 1;
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    // Validaciones mínimas
+    if (argc < 2) {
+        usage(prog);
+        return 1;
+    }
+
+    // Cada política comprueba sus argumentos; el último es siempre el fichero
+    char *policyName = argv[1];
+    int quantum = 0;
+    if (strcmp(policyName, "FCFS") == 0) {
+        if (argc != 3) {
+            printf("Usage for FCFS: %s [options] FCFS <filename>\n", prog);
+            return 1;
+        }
+    } else if (strcmp(policyName, "RR") == 0) {
+        if (argc != 4) {
+            printf("Usage for RR: %s [options] RR <quantum|auto> <filename>\n", prog);
+            return 1;
+        }
+        // Con auto el quantum lo va eligiendo el planificador (quantum = 0)
+        quantum = strcmp(argv[2], "auto") == 0 ? 0 : atoi(argv[2]);
+        if (quantum <= 0 && strcmp(argv[2], "auto") != 0) {
+            printf("Invalid quantum value. Must be positive.\n");
+            return 1;
+        }
+    } else if (strcmp(policyName, "MLFQ") == 0) {
+        if (argc != 5) {
+            printf("Usage for MLFQ: %s [options] MLFQ <q0,q1,...> <boost_ms> <filename>\n", prog);
+            return 1;
+        }
+        if (initMlfq(argv[2], atoi(argv[3])) < 0) {
+            printf("Invalid MLFQ parameters. Use positive quanta (max %d levels) and boost period.\n",
+                   MLFQ_MAX_LEVELS);
+            return 1;
+        }
+    } else if (strcmp(policyName, "EDF") == 0) {
+        if (argc != 3) {
+            printf("Usage for EDF: %s [options] EDF <filename>\n", prog);
+            return 1;
+        }
+        // La prueba de utilización usa expect= o, si no lo hay, el historial
+        loadHistory(historyFile);
+    } else if (strcmp(policyName, "SJF") == 0 || strcmp(policyName, "SRTF") == 0) {
+        if (argc != 3) {
+            printf("Usage for %s: %s [options] %s <filename>\n", policyName, prog, policyName);
+            return 1;
+        }
+        loadHistory(historyFile);
+    } else if (strcmp(policyName, "FAIR") == 0) {
+        if (argc != 4) {
+            printf("Usage for FAIR: %s [options] FAIR <latency_ms> <filename>\n", prog);
+            return 1;
+        }
+        quantum = atoi(argv[2]);
+        if (quantum <= 0) {
+            printf("Invalid latency value. Must be positive.\n");
+            return 1;
+        }
+    } else if (strcmp(policyName, "PRIO") == 0) {
+        if (argc != 4) {
+            printf("Usage for PRIO: %s [options] PRIO <quantum> <filename>\n", prog);
+            return 1;
+        }
+        quantum = atoi(argv[2]);
+        if (quantum <= 0) {
+            printf("Invalid quantum value. Must be positive.\n");
+            return 1;
+        }
+    } else {
+        printf("Invalid policy name. Use 'FCFS', 'RR', 'MLFQ', 'SJF', 'SRTF', 'FAIR', 'PRIO' or 'EDF'.\n");
+        return 1;
+    }
+    char *filename = argv[argc - 1];
+
+    startSec = nowSeconds();
+
+    if (tracePath != NULL) {
+        traceInit();
+    }
+    // Lo que quede en el anillo de registro sale también si se termina con exit
+    atexit(logFlush);
+
+    // Creamos las colas, los slots, la tabla de finalización y el conjunto epoll
+    Queue* processQueue = createQueue();
+    readyQueue = createQueue();
+    if (simulating) {
+        // Nada que fijar ni abrir: la traza se lee según avanza el reloj
+        initSlots(jobs, 0);
+        launchBackend = LAUNCH_FORK;
+        if (!openJobReader(&simTrace, filename)) {
+            perror("Failed to open trace");
+            return 1;
+        }
+    } else {
+        initSlots(jobs, pin);
+        tableInit(64);
+        installSigchldHandler();
+        initEventLoop();
+        heapInit(&pendingArrivals, arrivesBefore);
+        if (capturingOutput()) {
+            initOutput();
+        }
+        if (memoryControl()) {
+            initMemory();
+        }
+        if (preemptBackend == &cgroupBackend && initCgroupBase() == -1) {
+            logMsg(LOG_ERROR, "Warning: cgroup v2 not writable, preempting with signals\n");
+            preemptBackend = &signalBackend;
+        }
+        if (controlPath != NULL) {
+            openControl(controlPath);
+        }
+        if (!openIntake(filename)) {
+            loadProcessesFromFile(filename, processQueue);
+        }
+    }
+    if (strcmp(policyName, "RR") == 0 && quantum == 0) {
+        roundRobinAdaptive(processQueue);
+    } else if (strcmp(policyName, "RR") == 0) {
+        roundRobin(processQueue, quantum);
+    } else if (strcmp(policyName, "MLFQ") == 0) {
+        multiLevelFeedbackQueue(processQueue);
+    } else if (strcmp(policyName, "SJF") == 0) {
+        shortestJobFirst(processQueue, 0);
+    } else if (strcmp(policyName, "SRTF") == 0) {
+        shortestJobFirst(processQueue, 1);
+    } else if (strcmp(policyName, "FAIR") == 0) {
+        fairScheduler(processQueue, quantum);
+    } else if (strcmp(policyName, "PRIO") == 0) {
+        priorityScheduler(processQueue, quantum);
+    } else if (strcmp(policyName, "EDF") == 0) {
+        earliestDeadlineFirst(processQueue);
+    } else {
+        firstComeFirstServe(processQueue);
+    }
+    if (policy->report) {
+        policy->report();
+    }
+    dagReport(nowSeconds() - startSec);
+    writeMetrics(policyName, quantum);
+    if (tracePath != NULL) {
+        writeTrace(tracePath);
+    }
+    if (simulating) {
+        // Lo aprendido de una traza simulada no va al historial real
+        closeJobReader(&simTrace);
+    } else {
+        closeIntake(filename);
+        if (controlFd >= 0) {
+            closeControl(controlPath);
+        }
+        saveHistory();
+        printLaunchStats();
+        printSwitchStats();
+        if (memoryControl()) {
+            printMemoryStats();
+            closeMemory();
+        }
+        closeEventLoop();
+        close(sigEventFd);
+        if (devNullFd >= 0) {
+            close(devNullFd);
+        }
+        closeCgroupBase();
+    }
+
+    // Liberamos las colas
+    while (!isQueueEmpty(processQueue)) {
+        Process* p = dequeue(processQueue);
+        freeProcess(p);
+    }
+    destroyQueue(processQueue);
+    while (!isQueueEmpty(readyQueue)) {
+        freeProcess(dequeue(readyQueue));
+    }
+    destroyQueue(readyQueue);
+    destroyMlfq();
+    if (sjfHeap.ids != NULL) {
+        heapDestroy(&sjfHeap);
+    }
+    if (edfHeap.ids != NULL) {
+        while (!edfEmpty()) {
+            freeProcess(edfPop());
+        }
+        heapDestroy(&edfHeap);
+        free(edfLateness);
+    }
+    if (pendingArrivals.ids != NULL) {
+        heapDestroy(&pendingArrivals);
+    }
+    historyFree();
+    destroyFair();
+    destroyPrio();
+    free(traceRing);
+    free(completions.pids);
+    free(completions.procs);
+    free(slots);
+    free(spawnStack);
+    for (int i = 0; i < numMetrics; i++) {
+        free(metrics[i].output);
+    }
+    free(metrics);
+    free(quantumHistory);
+    dagFree();
+    routeCacheFree();
+    destroyPool();
+
+    return 0;
+}
+#endif
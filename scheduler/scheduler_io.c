@@ -8,13 +8,17 @@
 #include <unistd.h>
 #include <signal.h>
 #include <time.h>
-
-volatile int exit_flag = 0; // Para que el padre en FCFS espere, pero también maneje señales
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include <stdarg.h>
+#include <sys/uio.h>
 
 typedef enum {
     NEW,
     RUNNING,
     STOPPED,
+    BLOCKED, // Haciendo E/S: entre SIGUSR1 y SIGUSR2
     EXITED
 } ExecutionStatus;
 
@@ -24,16 +28,24 @@ typedef enum {
 typedef struct Process {
     char executableName[256]; // Nombre del binario (p.ej. "work7")
     char route[256];          // Ruta completa (p.ej. "./work/work7")
+    char args[256];           // Argumentos tras " -- " (p.ej. "-p 100,300,100")
     int pid;                  // PID
     ExecutionStatus status;   // Estado
     struct timeval entryTime; // Momento en que se encoló
     int remainingTime;
-    
+    struct rusage usage;      // Consumo que devuelve wait4 al recogerlo
+    int boosted;              // Vuelve de E/S: va primero y con quantum corto (RR)
 } Process;
 
-// Para usar en FCFS/RR cuando un proceso termina
-Process *terminatedProcess = NULL;
+// Proceso que ocupa la CPU. Solo lo toca el bucle principal, nunca un handler.
+Process *runningProcess = NULL;
+struct timeval sliceStart; // Inicio del quantum de runningProcess (RR)
+int sliceMs = 0;           // Quantum armado para runningProcess (0 = ninguno)
 
+// Procesos en E/S. No hace falta una cola: al llegar SIGUSR2 se busca el
+// proceso por si_pid en la tabla de finalización, así que pueden estar
+// varios en E/S a la vez y terminar en cualquier orden.
+int ioCount = 0;
 
 // Nodo de la cola
 typedef struct Node {
@@ -59,8 +71,8 @@ Queue* createQueue() {
     q->rear = NULL;
     return q;
 }
-Queue* ioQueue;
 Queue* processQueue;
+Queue* boostQueue; // Recién salidos de E/S en RR: se sirven antes que processQueue
 
 int isQueueEmpty(Queue *q) {
     return (q->front == NULL);
@@ -98,6 +110,95 @@ Process* dequeue(Queue *q) {
     return p;
 }
 
+// Quita p de la cola si está. O(n), solo para el caso raro de un proceso
+// que pide E/S justo cuando lo expulsábamos.
+int removeFromQueue(Queue *q, Process *p) {
+    Node *prev = NULL;
+    for (Node *n = q->front; n != NULL; prev = n, n = n->next) {
+        if (n->process != p) {
+            continue;
+        }
+        if (prev == NULL) {
+            q->front = n->next;
+        } else {
+            prev->next = n->next;
+        }
+        if (q->rear == n) {
+            q->rear = prev;
+        }
+        free(n);
+        return 1;
+    }
+    return 0;
+}
+
+// ------------------ Registro ------------------
+
+// Como en scheduler.c: los mensajes se formatean en registros de tamaño fijo
+// de un anillo preasignado y logFlush los escribe con un solo writev antes
+// de esperar señales. Los handlers nunca registran; solo apuntan en childRing.
+typedef enum {
+    LOG_ERROR, // Avisos
+    LOG_INFO,  // Un mensaje por trabajo y por E/S
+    LOG_DEBUG  // Un mensaje por quantum (Pausing, Resuming, Enqueued)
+} LogLevel;
+
+#define LOG_RECORD_SIZE 512
+#define LOG_RING_SIZE 256 // Registros por writev (menor que IOV_MAX)
+
+LogLevel logLevel = LOG_DEBUG;
+char logText[LOG_RING_SIZE][LOG_RECORD_SIZE];
+struct iovec logIov[LOG_RING_SIZE];
+int logCount = 0;
+
+void logFlush() {
+    struct iovec *iov = logIov;
+    int n = logCount;
+    while (n > 0) {
+        ssize_t w = writev(STDOUT_FILENO, iov, n);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        while (n > 0 && (size_t)w >= iov->iov_len) {
+            w -= (ssize_t)iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char*)iov->iov_base + w;
+            iov->iov_len -= (size_t)w;
+        }
+    }
+    logCount = 0;
+}
+
+__attribute__((format(printf, 2, 3)))
+void logMsg(LogLevel level, const char *fmt, ...) {
+    if (level > logLevel) {
+        return;
+    }
+    if (logCount == LOG_RING_SIZE) {
+        logFlush();
+    }
+    char *text = logText[logCount];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(text, LOG_RECORD_SIZE, fmt, ap);
+    va_end(ap);
+    if (len < 0) {
+        return;
+    }
+    if (len >= LOG_RECORD_SIZE) {
+        len = LOG_RECORD_SIZE - 1;
+        text[len - 1] = '\n';
+    }
+    logIov[logCount].iov_base = text;
+    logIov[logCount].iov_len = (size_t)len;
+    logCount++;
+}
 
 // ------------------ Funciones auxiliares ------------------
 
@@ -132,6 +233,9 @@ void loadProcessesFromFile(const char *filename, Queue *q) {
     char line[256];
     while (fgets(line, sizeof(line), file)) {
         line[strcspn(line, "\n")] = '\0';  // Quitar el salto de línea
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
 
         Process *newProcess = (Process*)malloc(sizeof(Process));
         if (!newProcess) {
@@ -140,6 +244,16 @@ void loadProcessesFromFile(const char *filename, Queue *q) {
             exit(EXIT_FAILURE);
         }
 
+        // Como en scheduler.c, lo que sigue a " -- " son los argumentos del
+        // programa; las opciones key=value de la ruta no se usan aquí
+        newProcess->args[0] = '\0';
+        char *dashes = strstr(line, " -- ");
+        if (dashes) {
+            strcpy(newProcess->args, dashes + 4);
+            *dashes = '\0';
+        }
+        line[strcspn(line, " \t")] = '\0';
+
         // route contendrá algo como "./work/work7"
         strcpy(newProcess->route, line);
         // extraer solo "work7"
@@ -149,100 +263,481 @@ void loadProcessesFromFile(const char *filename, Queue *q) {
         newProcess->status = NEW;
         gettimeofday(&newProcess->entryTime, NULL);
         newProcess->remainingTime = 0; // Por defecto
+        memset(&newProcess->usage, 0, sizeof(newProcess->usage));
+        newProcess->boosted = 0;
 
         enqueue(q, newProcess);
-        printf("Enqueued process: %s\n", newProcess->executableName);
+        logMsg(LOG_DEBUG, "Enqueued process: %s\n", newProcess->executableName);
     }
 
     fclose(file);
 }
 
+// ------------------ Tabla de finalización ------------------
+
+// Tabla hash PID -> Process (direccionamiento abierto, sondeo lineal) con los
+// hijos lanzados que aún no se han recogido. Solo se llama a wait4 sobre PIDs
+// que están en la tabla y se quitan al recogerlos, así que un mismo hijo no
+// se recoge dos veces aunque lleguen varios avisos de su salida.
+typedef struct CompletionTable {
+    pid_t *pids;       // 0 = hueco libre
+    Process **procs;
+    int capacity;      // Siempre potencia de 2
+    int count;
+} CompletionTable;
+
+CompletionTable completions = {NULL, NULL, 0, 0};
+
+unsigned pidHash(pid_t pid, int capacity) {
+    return ((unsigned)pid * 2654435761u) & (unsigned)(capacity - 1);
+}
+
+void tableInit(int capacity) {
+    completions.pids = (pid_t*)calloc(capacity, sizeof(pid_t));
+    completions.procs = (Process**)calloc(capacity, sizeof(Process*));
+    if (!completions.pids || !completions.procs) {
+        perror("Failed to allocate memory for completion table");
+        exit(EXIT_FAILURE);
+    }
+    completions.capacity = capacity;
+    completions.count = 0;
+}
+
+void tableInsert(pid_t pid, Process *p) {
+    // Crecemos al 50% de ocupación para que los sondeos sean cortos
+    if ((completions.count + 1) * 2 > completions.capacity) {
+        CompletionTable old = completions;
+        tableInit(old.capacity * 2);
+        for (int i = 0; i < old.capacity; i++) {
+            if (old.pids[i] != 0) {
+                tableInsert(old.pids[i], old.procs[i]);
+            }
+        }
+        free(old.pids);
+        free(old.procs);
+    }
+    unsigned mask = (unsigned)(completions.capacity - 1);
+    unsigned i = pidHash(pid, completions.capacity);
+    while (completions.pids[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    completions.pids[i] = pid;
+    completions.procs[i] = p;
+    completions.count++;
+}
+
+Process* tableLookup(pid_t pid) {
+    unsigned mask = (unsigned)(completions.capacity - 1);
+    unsigned i = pidHash(pid, completions.capacity);
+    while (completions.pids[i] != 0) {
+        if (completions.pids[i] == pid) {
+            return completions.procs[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+void tableRemove(pid_t pid) {
+    unsigned mask = (unsigned)(completions.capacity - 1);
+    unsigned i = pidHash(pid, completions.capacity);
+    while (completions.pids[i] != pid) {
+        if (completions.pids[i] == 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    // Borrado con desplazamiento hacia atrás: recolocamos las entradas
+    // siguientes del mismo grupo para no dejar huecos en sus sondeos
+    unsigned j = i;
+    while (1) {
+        completions.pids[i] = 0;
+        completions.procs[i] = NULL;
+        while (1) {
+            j = (j + 1) & mask;
+            if (completions.pids[j] == 0) {
+                completions.count--;
+                return;
+            }
+            unsigned k = pidHash(completions.pids[j], completions.capacity);
+            // La entrada j puede ocupar el hueco i si su posición ideal k no
+            // está en el tramo circular (i, j]
+            if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+                break;
+            }
+        }
+        completions.pids[i] = completions.pids[j];
+        completions.procs[i] = completions.procs[j];
+        i = j;
+    }
+}
+
 // ------------------ Handlers ------------------
 
-void sigchld_handler(int signo) {
-    (void)signo;
-    if (terminatedProcess == NULL) {
-        // A veces puede llegar SIGCHLD sin que hayamos asignado terminatedProcess
-        // en FCFS, etc. Depende de la lógica. Lo ignoramos.
-        return;
+// Los handlers no tocan colas ni procesos: solo apuntan qué hijo envió qué
+// señal en un anillo sin bloqueos. El bucle principal lo vacía con las
+// señales bloqueadas y hace el trabajo (wait4, mover entre colas, informes).
+#define CHILD_RING_SIZE 1024 // Potencia de 2
+
+typedef enum {
+    CHILD_EXIT,     // SIGCHLD
+    CHILD_IO_START, // SIGUSR1
+    CHILD_IO_END,   // SIGUSR2
+    QUANTUM_EXPIRED // SIGALRM (pid 0)
+} ChildEventKind;
+
+typedef struct ChildRecord {
+    pid_t pid;
+    ChildEventKind kind;
+} ChildRecord;
+
+ChildRecord childRing[CHILD_RING_SIZE];
+_Atomic unsigned childRingHead = 0; // Solo lo avanzan los handlers
+_Atomic unsigned childRingTail = 0; // Solo lo avanza el bucle principal
+sigset_t origMask;                  // Máscara original, para sigsuspend y los hijos
+
+// Los handlers se instalan bloqueando las demás señales del anillo, así que
+// nunca se interrumpen entre sí y el anillo tiene un único productor a la vez
+void pushChildRecord(pid_t pid, ChildEventKind kind) {
+    unsigned head = atomic_load_explicit(&childRingHead, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&childRingTail, memory_order_acquire);
+    if (head - tail < CHILD_RING_SIZE) {
+        childRing[head & (CHILD_RING_SIZE - 1)].pid = pid;
+        childRing[head & (CHILD_RING_SIZE - 1)].kind = kind;
+        atomic_store_explicit(&childRingHead, head + 1, memory_order_release);
+    }
+}
+
+int childRingEmpty() {
+    return atomic_load_explicit(&childRingHead, memory_order_acquire) ==
+           atomic_load_explicit(&childRingTail, memory_order_relaxed);
+}
+
+void sigchld_handler(int sign, siginfo_t* info, void* context) {
+    pushChildRecord(info->si_pid, CHILD_EXIT);
+}
+void sigUsr1_handler(int sign, siginfo_t* info, void* context) {
+    pushChildRecord(info->si_pid, CHILD_IO_START);
+}
+void sigUsr2_handler(int sign, siginfo_t* info, void* context) {
+    pushChildRecord(info->si_pid, CHILD_IO_END);
+}
+void sigalrm_handler(int sign, siginfo_t* info, void* context) {
+    pushChildRecord(0, QUANTUM_EXPIRED);
+}
+
+void installHandler(int signo, void (*handler)(int, siginfo_t*, void*), int flags) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = handler;
+    sigemptyset(&sa.sa_mask);
+    sigaddset(&sa.sa_mask, SIGCHLD);
+    sigaddset(&sa.sa_mask, SIGUSR1);
+    sigaddset(&sa.sa_mask, SIGUSR2);
+    sigaddset(&sa.sa_mask, SIGALRM);
+    sa.sa_flags = SA_SIGINFO | SA_RESTART | flags;
+    if (sigaction(signo, &sa, NULL) == -1) {
+        perror("Error al configurar handler");
+        exit(EXIT_FAILURE);
     }
+}
+
+// ------------------ Finalización ------------------
 
+void printProcessReport(Process *p, int code) {
     struct timeval finishTime;
     gettimeofday(&finishTime, NULL);
+    double totalTime = timeval_diff(&p->entryTime, &finishTime);
+
+    logMsg(LOG_INFO,
+           "-----------------------------------------------------\n"
+           "Process %d finished with code: %d\n"
+           "Executable: %s\n"
+           "Route: %s\n"
+           "Time to execute: %.6f\n"
+           "-----------------------------------------------------\n",
+           p->pid, code, p->executableName, p->route, totalTime);
+}
+
+// Arma el quantum de runningProcess con un SIGALRM dentro de ms (0 = desarmar)
+void armQuantum(int ms) {
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    it.it_value.tv_sec = ms / 1000;
+    it.it_value.tv_usec = (ms % 1000) * 1000;
+    setitimer(ITIMER_REAL, &it, NULL);
+    sliceMs = ms;
+    gettimeofday(&sliceStart, NULL);
+}
+
+// La CPU queda libre
+void releaseCpu() {
+    runningProcess = NULL;
+    if (sliceMs > 0) {
+        armQuantum(0);
+    }
+}
+
+// p ya se ha recogido: lo quitamos de la tabla, mostramos su informe y, si
+// ocupaba la CPU, la dejamos libre
+void finishProcess(Process *p, int code) {
+    ExecutionStatus prev = p->status;
+    tableRemove(p->pid);
+    if (prev == BLOCKED) {
+        ioCount--;
+    }
+    p->status = EXITED;
+    printProcessReport(p, code);
+    if (p == runningProcess) {
+        releaseCpu();
+    } else if (prev == STOPPED) {
+        // Murió parado en una cola: lo sacamos para no reanudarlo
+        if (!removeFromQueue(processQueue, p)) {
+            removeFromQueue(boostQueue, p);
+        }
+    }
+    free(p);
+}
+
+// Código de salida de un estado de wait4: 128 + señal si lo mató una señal,
+// como en el shell y en scheduler.c (WEXITSTATUS daría 0)
+int exitCode(int status) {
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+}
 
-    double totalTime = timeval_diff(&terminatedProcess->entryTime, &finishTime);
+// Recoge pid si ya terminó y está pendiente en la tabla de finalización
+void completeChild(pid_t pid) {
+    Process *p = tableLookup(pid);
+    if (p == NULL) {
+        // Ya se recogió con otro aviso
+        return;
+    }
     int status;
-    // Esperar al proceso que terminó
-    waitpid(terminatedProcess->pid, &status, 0);
-    terminatedProcess->status = EXITED;
-
-    // Mensajes de estilo FCFS
-    printf("-----------------------------------------------------\n");
-    printf("Process %d finished with code: %d\n", terminatedProcess->pid, WEXITSTATUS(status));
-    printf("Executable: %s\n", terminatedProcess->executableName);
-    printf("Route: %s\n", terminatedProcess->route);
-    printf("Time to execute: %.6f\n", totalTime);
-    printf("-----------------------------------------------------\n");
-    free(terminatedProcess);
-    terminatedProcess = NULL;
-    exit_flag = 1;
-}
-void sigUsr1_handler(int sign) {
-    printf("Starting I/O routine\n");
-    enqueue(ioQueue,terminatedProcess);
-    exit_flag = 1;
-    
+    if (wait4(pid, &status, WNOHANG, &p->usage) > 0) {
+        finishProcess(p, exitCode(status));
+    }
 }
-void sigUsr2_handler(int sign, siginfo_t* info, void* context) {
-    pid_t sender_pid = info->si_pid; // Obtener el PID del proceso que envió SIGUSR2
-    printf("Process with  PID %d finished the I/O routine \n", sender_pid);
-    //Also you can just deque because it is a FIFO but i think its risky 
-    Process* proc = dequeue(ioQueue);
-    proc->status = STOPPED;
-    printf("...\n");	 
-    enqueue(processQueue,proc);
+
+int ioBoostMs = 0; // Quantum tras volver de E/S (RR); 0 = sin prioridad
+
+// Expulsa runningProcess al vencer su quantum y lo manda al final de la cola
+void preemptRunning() {
+    Process *p = runningProcess;
+    int status;
+    if (wait4(p->pid, &status, WNOHANG, &p->usage) > 0) {
+        // Terminó en el último momento
+        finishProcess(p, exitCode(status));
+        return;
+    }
+    logMsg(LOG_DEBUG, "Pausing process: %s (PID: %d)\n", p->executableName, p->pid);
+    kill(p->pid, SIGSTOP);
+    p->status = STOPPED;
+    p->remainingTime -= sliceMs;
+    releaseCpu();
+    enqueue(processQueue, p);
 }
 
+// Procesa todos los avisos pendientes. Se llama con las señales bloqueadas.
+void drainChildRing() {
+    unsigned tail = atomic_load_explicit(&childRingTail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&childRingHead, memory_order_acquire);
+    while (tail != head) {
+        ChildRecord rec = childRing[tail & (CHILD_RING_SIZE - 1)];
+        tail++;
+        atomic_store_explicit(&childRingTail, tail, memory_order_release);
+
+        if (rec.kind == CHILD_EXIT) {
+            completeChild(rec.pid);
+        } else if (rec.kind == CHILD_IO_START) {
+            Process *p = tableLookup(rec.pid);
+            if (p == NULL || p->status == BLOCKED) {
+                continue;
+            }
+            logMsg(LOG_INFO, "Starting I/O routine\n");
+            if (p == runningProcess) {
+                releaseCpu();
+            } else if (p->status == STOPPED) {
+                // Lo expulsamos justo cuando empezaba la E/S: que la haga
+                // ya en vez de esperar su turno parado en la cola
+                if (!removeFromQueue(processQueue, p)) {
+                    removeFromQueue(boostQueue, p);
+                }
+                siginfo_t info;
+                waitid(P_PID, p->pid, &info, WSTOPPED);
+                kill(p->pid, SIGCONT);
+            }
+            p->status = BLOCKED;
+            ioCount++;
+        } else if (rec.kind == CHILD_IO_END) {
+            logMsg(LOG_INFO, "Process with  PID %d finished the I/O routine \n", rec.pid);
+            Process *p = tableLookup(rec.pid);
+            if (p == NULL || p->status != BLOCKED) {
+                continue;
+            }
+            // Tras SIGUSR2 el hijo se para solo con raise(SIGSTOP)
+            p->status = STOPPED;
+            ioCount--;
+            logMsg(LOG_DEBUG, "...\n");
+            if (ioBoostMs > 0) {
+                p->boosted = 1;
+                enqueue(boostQueue, p);
+            } else {
+                enqueue(processQueue, p);
+            }
+        } else if (rec.kind == QUANTUM_EXPIRED) {
+            // Un SIGALRM de un quantum ya desarmado llega tarde: se ignora
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            if (runningProcess != NULL && sliceMs > 0 &&
+                timeval_diff(&sliceStart, &now) * 1000 >= sliceMs - 1) {
+                preemptRunning();
+            }
+        }
+    }
 
-// ------------------ FCFS ------------------
-void firstComeFirstServe(Queue* processes) {
-    Process* currentProc;
+    // SIGCHLD no se encola: si varios hijos terminan a la vez puede llegar
+    // un único aviso, así que barremos los que queden
+    int status;
+    struct rusage usage;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        Process *p = tableLookup(pid);
+        if (p != NULL) {
+            p->usage = usage;
+            finishProcess(p, exitCode(status));
+        }
+    }
+}
 
-    while (!isQueueEmpty(processes)) {
-        exit_flag = 0;
-        currentProc = dequeue(processes);
-        terminatedProcess = currentProc;
 
-        if (currentProc->status == STOPPED) {
-            kill(currentProc->pid, SIGCONT);
-        } else {
-            
-            pid_t pid = fork();
-            if (pid < 0) {
-                perror("Fork failed");
-                free(currentProc);
-                return;
-            } else if (pid == 0) {
-               
-                currentProc->pid = getpid();
-                currentProc->status = RUNNING;
-                execlp(currentProc->route, currentProc->executableName, NULL);
-                perror("Execution failed");
-                exit(EXIT_FAILURE);
-            } 
+// ------------------ Despacho ------------------
+
+// Pone p en la CPU: lo lanza si es nuevo o lo reanuda si estaba parado.
+// Devuelve -1 si no se pudo crear el hijo.
+int runOnCpu(Process *p, int verbose) {
+    if (p->status == STOPPED) {
+        // El hijo avisa con SIGUSR2 justo antes de hacer raise(SIGSTOP):
+        // esperamos a que esté parado de verdad o el SIGCONT se perdería
+        siginfo_t info;
+        waitid(P_PID, p->pid, &info, WSTOPPED);
+        if (verbose) {
+            logMsg(LOG_DEBUG, "Resuming process: %s (PID: %d)\n", p->executableName, p->pid);
+        }
+        kill(p->pid, SIGCONT);
+    } else {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Fork failed");
+            free(p);
+            return -1;
+        } else if (pid == 0) {
+            sigprocmask(SIG_SETMASK, &origMask, NULL);
+            char *args[64];
+            int n = 0;
+            args[n++] = p->executableName;
+            for (char *t = strtok(p->args, " \t"); t != NULL && n < 63; t = strtok(NULL, " \t")) {
+                args[n++] = t;
+            }
+            args[n] = NULL;
+            execvp(p->route, args);
+            perror("Execution failed");
+            _exit(EXIT_FAILURE); // Sin atexit: el anillo de registro es del padre
+        }
+        p->pid = pid;
+        tableInsert(pid, p);
+        if (verbose) {
+            logMsg(LOG_INFO, "Started process: %s (PID: %d)\n", p->executableName, p->pid);
+        }
+    }
+    p->status = RUNNING;
+    runningProcess = p;
+    return 0;
+}
+
+// Bucle común a FCFS y RR. Mientras un proceso está en E/S la CPU pasa al
+// siguiente; quantum 0 deja correr a cada uno hasta que termina o pide E/S.
+void schedule(Queue* processes, int quantum) {
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGUSR1);
+    sigaddset(&block, SIGUSR2);
+    sigaddset(&block, SIGALRM);
+    // Fuera de sigsuspend las señales quedan bloqueadas para no perder avisos
+    sigprocmask(SIG_BLOCK, &block, &origMask);
+
+    while (!isQueueEmpty(processes) || !isQueueEmpty(boostQueue) ||
+           ioCount > 0 || runningProcess != NULL) {
+        if (runningProcess == NULL &&
+            (!isQueueEmpty(boostQueue) || !isQueueEmpty(processes))) {
+            // Los que vuelven de E/S van primero, pero con un quantum corto
+            Process *currentProc;
+            int slice = quantum;
+            if (!isQueueEmpty(boostQueue)) {
+                currentProc = dequeue(boostQueue);
+                currentProc->boosted = 0;
+                slice = ioBoostMs;
+            } else {
+                currentProc = dequeue(processes);
+            }
+            if (runOnCpu(currentProc, quantum > 0) < 0) {
+                continue;
+            }
+            if (slice > 0) {
+                armQuantum(slice);
+            }
         }
-        while (exit_flag == 0) {
-            pause();
+
+        logFlush();
+        while (childRingEmpty()) {
+            sigsuspend(&origMask);
         }
+        drainChildRing();
     }
+
+    sigprocmask(SIG_SETMASK, &origMask, NULL);
+}
+
+// ------------------ FCFS ------------------
+void firstComeFirstServe(Queue* processes) {
+    ioBoostMs = 0;
+    schedule(processes, 0);
+}
+
+// ------------------ Round Robin ------------------
+
+// RR que solapa CPU y E/S: el que pide E/S suelta la CPU y, cuando acaba,
+// vuelve delante de la cola con un cuarto del quantum
+void roundRobin(Queue* processes, int quantum) {
+    ioBoostMs = quantum / 4 > 0 ? quantum / 4 : 1;
+    schedule(processes, quantum);
 }
 
 // ------------------ main ------------------
 
 int main(int argc, char **argv) {
+    // -L error|info|debug: nivel de registro (por defecto debug)
+    char *prog = argv[0];
+    int opt;
+    while ((opt = getopt(argc, argv, "+L:")) != -1) {
+        if (opt == 'L' && strcmp(optarg, "error") == 0) {
+            logLevel = LOG_ERROR;
+        } else if (opt == 'L' && strcmp(optarg, "info") == 0) {
+            logLevel = LOG_INFO;
+        } else if (opt == 'L' && strcmp(optarg, "debug") == 0) {
+            logLevel = LOG_DEBUG;
+        } else {
+            printf("Usage: %s [-L error|info|debug] <policy> [quantum] <filename>\n", prog);
+            return 1;
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+    argv[0] = prog;
+
     // Validaciones mínimas
     if (argc < 2) {
-        printf("Usage: %s <policy> [quantum] <filename>\n", argv[0]);
+        printf("Usage: %s [-L error|info|debug] <policy> [quantum] <filename>\n", argv[0]);
         return 1;
     }
 
@@ -262,20 +757,18 @@ int main(int argc, char **argv) {
     }
 
     // Creamos la cola y asignamos handler
+    atexit(logFlush);
     processQueue = createQueue();
-    ioQueue = createQueue();
-
-    signal(SIGCHLD, sigchld_handler);
-    signal(SIGUSR1, sigUsr1_handler);
-    struct sigaction  sa_usr2;
-    // Configuración para SIGUSR2 (usando sigaction para obtener más control)
-    sa_usr2.sa_sigaction = sigUsr2_handler;  // Usamos la versión con siginfo_t para obtener información adicional
-    sigemptyset(&sa_usr2.sa_mask);           // No bloquear señales durante la ejecución del handler
-    sa_usr2.sa_flags = SA_SIGINFO;           // Especificamos que usamos siginfo_t
-    if (sigaction(SIGUSR2, &sa_usr2, NULL) == -1) {
-        perror("Error al configurar SIGUSR2");
-        exit(EXIT_FAILURE);
-    }
+    boostQueue = createQueue();
+
+    tableInit(64);
+    // Los tres handlers usan siginfo_t para saber qué hijo envió la señal.
+    // Las paradas de los hijos no generan SIGCHLD: al reanudar las
+    // esperamos con waitid.
+    installHandler(SIGCHLD, sigchld_handler, SA_NOCLDSTOP);
+    installHandler(SIGUSR1, sigUsr1_handler, 0);
+    installHandler(SIGUSR2, sigUsr2_handler, 0);
+    installHandler(SIGALRM, sigalrm_handler, 0);
 
  
     if (strcmp(policy, "RR") == 0) {
@@ -301,7 +794,9 @@ int main(int argc, char **argv) {
         free(p);
     }
     free(processQueue);
-    free(ioQueue);
+    free(boostQueue);
+    free(completions.pids);
+    free(completions.procs);
 
     return 0;
 }
@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+
+/*
+ * Carga de trabajo parametrizada: un único binario en lugar de work1..work7.
+ *
+ *   work [-m cpu|mem|cache] [-s size_kb] [-c file] [-r] [-p] [-t] cpu_ms[,io_ms,cpu_ms...]
+ *
+ * El patrón alterna ráfagas de CPU e I/O en milisegundos, igual que bursts=
+ * en los ficheros de trabajos. Las ráfagas de CPU se convierten en
+ * iteraciones de core_delay con una calibración por máquina (iteraciones por
+ * ms de CPU), de modo que "100 ms" signifique lo mismo en cualquier host.
+ * La calibración se guarda en un fichero (por defecto ~/.work_calibration,
+ * o $WORK_CALIBRATION) y sólo se repite si falta o con -r.
+ *
+ * Modos:
+ *   cpu    aritmética en registros (como work.c)
+ *   mem    recorre un buffer de size_kb escribiendo una línea de caché por paso
+ *   cache  persecución de punteros aleatoria sobre size_kb: un fallo por paso
+ *
+ * -p usa el protocolo de scheduler_io para la I/O (SIGUSR1 al padre, espera,
+ * SIGUSR2 y SIGSTOP, como work_io.c). Sin -p la I/O es un simple nanosleep.
+ *
+ * -t escribe en stderr, antes de nada, el instante de arranque de main en ns
+ * de CLOCK_MONOTONIC (lo usa bench_sched para medir la latencia de despacho).
+ */
+
+#define UNIT_STEPS 1000        /* pasos por llamada a core_delay */
+#define CAL_ROUNDS 3           /* rondas de calibración; nos quedamos con la mejor */
+#define CAL_MS 20              /* ms de CPU por ronda */
+#define DEFAULT_SIZE_KB 65536  /* buffer para mem/cache: mayor que la LLC */
+#define LINE 64
+
+enum { MODE_CPU, MODE_MEM, MODE_CACHE };
+const char *mode_names[] = { "cpu", "mem", "cache" };
+
+double a = 1.1;
+unsigned char *buffer;
+size_t *chain;
+size_t buffer_len, chain_len, cursor;
+
+void core_delay_cpu()
+{
+	unsigned long j;
+
+	for (j = 0; j < UNIT_STEPS; j++) {
+		a += sqrt(1.1)*sqrt(1.2)*sqrt(1.3)*sqrt(1.4)*sqrt(1.5);
+		a += sqrt(1.6)*sqrt(1.7)*sqrt(1.8)*sqrt(1.9)*sqrt(2.0);
+	}
+}
+
+void core_delay_mem()
+{
+	unsigned long j;
+
+	for (j = 0; j < UNIT_STEPS; j++) {
+		buffer[cursor]++;
+		cursor += LINE;
+		if (cursor >= buffer_len)
+			cursor = 0;
+	}
+}
+
+void core_delay_cache()
+{
+	unsigned long j;
+	size_t i = cursor;
+
+	for (j = 0; j < UNIT_STEPS; j++)
+		i = chain[i];
+	cursor = i;
+}
+
+void (*core_delay)() = core_delay_cpu;
+
+/* Prepara el buffer del modo: páginas tocadas y, para cache, un ciclo
+ * aleatorio (Sattolo) de una línea por nodo para que el prefetch no ayude */
+void setup_mode(int mode, long size_kb)
+{
+	size_t i;
+
+	if (mode == MODE_CPU)
+		return;
+	buffer_len = (size_t)size_kb * 1024;
+	if (mode == MODE_MEM) {
+		buffer = malloc(buffer_len);
+		if (buffer == NULL) {
+			perror("malloc failed");
+			exit(EXIT_FAILURE);
+		}
+		memset(buffer, 0, buffer_len);
+		core_delay = core_delay_mem;
+		return;
+	}
+	chain_len = buffer_len / LINE;
+	if (chain_len < 2)
+		chain_len = 2;
+	/* Un size_t por línea: el índice siguiente vive en el primer hueco */
+	chain = malloc(chain_len * LINE);
+	if (chain == NULL) {
+		perror("malloc failed");
+		exit(EXIT_FAILURE);
+	}
+	size_t stride = LINE / sizeof(size_t);
+	size_t *order = malloc(chain_len * sizeof(size_t));
+	if (order == NULL) {
+		perror("malloc failed");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < chain_len; i++)
+		order[i] = i;
+	srand(getpid());
+	for (i = chain_len - 1; i > 0; i--) {
+		size_t k = (size_t)rand() % i;
+		size_t t = order[i];
+		order[i] = order[k];
+		order[k] = t;
+	}
+	for (i = 0; i < chain_len; i++)
+		chain[order[i] * stride] = order[(i + 1) % chain_len] * stride;
+	free(order);
+	cursor = 0;
+	core_delay = core_delay_cache;
+}
+
+double cpu_ms()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Iteraciones de core_delay por ms de CPU. Medimos tiempo de CPU del hilo,
+ * así que una expropiación durante la calibración no la falsea */
+double calibrate()
+{
+	double best = 0;
+	int r;
+
+	for (r = 0; r < CAL_ROUNDS; r++) {
+		double start = cpu_ms(), elapsed;
+		unsigned long units = 0;
+
+		/* Leer el reloj es una llamada al sistema: lo hacemos cada 64 */
+		do {
+			int k;
+			for (k = 0; k < 64; k++)
+				core_delay();
+			units += 64;
+			elapsed = cpu_ms() - start;
+		} while (elapsed < CAL_MS);
+		if (units / elapsed > best)
+			best = units / elapsed;
+	}
+	return best;
+}
+
+/* Busca en el fichero una calibración para este host, modo y tamaño */
+double load_calibration(const char *path, const char *host, int mode, long size_kb)
+{
+	char line[256], h[128], m[16];
+	long kb;
+	double rate, found = 0;
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL)
+		return 0;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%127s %15s %ld %lf", h, m, &kb, &rate) == 4 &&
+		    strcmp(h, host) == 0 && strcmp(m, mode_names[mode]) == 0 &&
+		    (mode == MODE_CPU || kb == size_kb) && rate > 0)
+			found = rate; /* la última línea gana: -r añade al final */
+	}
+	fclose(f);
+	return found;
+}
+
+/* Añade la calibración con una sola escritura en O_APPEND, así varios
+ * trabajos que calibran a la vez no mezclan sus líneas */
+void save_calibration(const char *path, const char *host, int mode, long size_kb, double rate)
+{
+	char line[256];
+	int len, fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+	if (fd == -1)
+		return;
+	len = snprintf(line, sizeof(line), "%s %s %ld %.3f\n", host, mode_names[mode],
+		       mode == MODE_CPU ? 0 : size_kb, rate);
+	if (write(fd, line, len) != len)
+		perror("write calibration");
+	close(fd);
+}
+
+void delay(int ms, double rate)
+{
+	unsigned long i;
+	unsigned long total_workload = (unsigned long)(ms * rate + 0.5);
+
+	for (i = 0; i < total_workload; i++)
+		core_delay();
+}
+
+void perform_io(int ms, int protocol)
+{
+	struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+
+	if (protocol)
+		kill(getppid(), SIGUSR1);
+	nanosleep(&ts, NULL);
+	if (protocol) {
+		kill(getppid(), SIGUSR2);
+		raise(SIGSTOP);
+	}
+}
+
+void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-m cpu|mem|cache] [-s size_kb] [-c file] [-r] [-p] [-t] "
+		"cpu_ms[,io_ms,cpu_ms...]\n", prog);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	struct timespec started;
+	int mode = MODE_CPU, recalibrate = 0, protocol = 0, stamp = 0, opt, i;
+	long size_kb = DEFAULT_SIZE_KB;
+
+	clock_gettime(CLOCK_MONOTONIC, &started);
+	const char *path = getenv("WORK_CALIBRATION");
+	char default_path[512], host[128];
+	int pid = getpid();
+
+	while ((opt = getopt(argc, argv, "m:s:c:rpt")) != -1) {
+		switch (opt) {
+		case 'm':
+			for (mode = 0; mode < 3; mode++)
+				if (strcmp(optarg, mode_names[mode]) == 0)
+					break;
+			if (mode == 3)
+				usage(argv[0]);
+			break;
+		case 's':
+			size_kb = atol(optarg);
+			if (size_kb <= 0)
+				usage(argv[0]);
+			break;
+		case 'c':
+			path = optarg;
+			break;
+		case 'r':
+			recalibrate = 1;
+			break;
+		case 'p':
+			protocol = 1;
+			break;
+		case 't':
+			stamp = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1)
+		usage(argv[0]);
+	if (stamp) {
+		char buf[32];
+		int len = snprintf(buf, sizeof(buf), "%lld\n",
+				   started.tv_sec * 1000000000LL + started.tv_nsec);
+		if (write(STDERR_FILENO, buf, len) != len)
+			perror("write stamp");
+	}
+
+	/* Patrón de ráfagas: CPU, I/O, CPU, ... */
+	int bursts[64], nbursts = 0, cpu_total = 0;
+	char *s = argv[optind], *end;
+	while (nbursts < 64) {
+		long v = strtol(s, &end, 10);
+		if (end == s || v < 0)
+			usage(argv[0]);
+		if (nbursts % 2 == 0)
+			cpu_total += (int)v;
+		bursts[nbursts++] = (int)v;
+		if (*end != ',')
+			break;
+		s = end + 1;
+	}
+	if (*end != '\0')
+		usage(argv[0]);
+
+	if (path == NULL) {
+		const char *home = getenv("HOME");
+		snprintf(default_path, sizeof(default_path), "%s/.work_calibration",
+			 home != NULL ? home : "/tmp");
+		path = default_path;
+	}
+	if (gethostname(host, sizeof(host)) != 0)
+		strcpy(host, "localhost");
+	host[sizeof(host) - 1] = '\0';
+
+	/* Sin ráfagas de CPU (work 0, un trabajo vacío) no hace falta calibrar */
+	setup_mode(mode, size_kb);
+	double rate = (recalibrate || cpu_total == 0) ? 0 : load_calibration(path, host, mode, size_kb);
+	if (rate == 0 && (cpu_total > 0 || recalibrate)) {
+		rate = calibrate();
+		save_calibration(path, host, mode, size_kb, rate);
+	}
+
+	printf("process %d begins\n", pid);
+	for (i = 0; i < nbursts; i++) {
+		if (i % 2 == 0) {
+			delay(bursts[i], rate);
+		} else {
+			printf("process %d starts io\n", pid);
+			perform_io(bursts[i], protocol);
+			printf("process %d completed io\n", pid);
+		}
+	}
+	printf("process %d ends\n", pid);
+
+	return 0;
+}